@@ -4,6 +4,7 @@
 #include "flowinity/EndpointsJSON.h"
 #include "imgupload/imguploadermanager.h"
 #include "imgupload/storages/imguploaderbase.h"
+#include "src/utils/codecs.h"
 #include "src/utils/confighandler.h"
 #include "abstractlogger.h"
 #include <QCheckBox>
@@ -12,7 +13,6 @@
 #include <QFileDialog>
 #include <QGroupBox>
 #include <QGuiApplication>
-#include <QImageWriter>
 #include <QLabel>
 #include <QLineEdit>
 #include <QMessageBox>
@@ -71,7 +71,11 @@ GeneralConf::GeneralConf(QWidget* parent)
     initShowSelectionGeometry();
     initShowMagnifier();
     initSquareMagnifier();
+    initSnapToWindows();
+    initMagneticSelection();
     initJpegQuality();
+    initPngCompressionLevel();
+    initEncodingPreset();
     // this has to be at the end
     initConfigButtons();
     updateComponents();
@@ -99,6 +103,8 @@ void GeneralConf::_updateComponents(bool allowEmptySavePath)
     m_allowMultipleGuiInstances->setChecked(config.allowMultipleGuiInstances());
     m_showMagnifier->setChecked(config.showMagnifier());
     m_squareMagnifier->setChecked(config.squareMagnifier());
+    m_snapToWindows->setChecked(config.snapToWindows());
+    m_magneticSelection->setChecked(config.magneticSelection());
     m_saveLastRegion->setChecked(config.saveLastRegion());
 
 #if !defined(Q_OS_WIN)
@@ -507,11 +513,7 @@ void GeneralConf::initSaveAfterCopy()
 
     m_setSaveAsFileExtension = new QComboBox(this);
 
-    QStringList imageFormatList;
-    foreach (auto mimeType, QImageWriter::supportedImageFormats())
-        imageFormatList.append(mimeType);
-
-    m_setSaveAsFileExtension->addItems(imageFormatList);
+    m_setSaveAsFileExtension->addItems(Codecs::formats());
 
     int currentIndex =
       m_setSaveAsFileExtension->findText(ConfigHandler().saveAsFileExtension());
@@ -1129,6 +1131,31 @@ void GeneralConf::initSquareMagnifier()
     });
 }
 
+void GeneralConf::initSnapToWindows()
+{
+    m_snapToWindows = new QCheckBox(tr("Snap the selection to windows"), this);
+    m_snapToWindows->setToolTip(
+      tr("Highlight the window under the cursor and select it with a click "
+         "(X11 only)"));
+    m_scrollAreaLayout->addWidget(m_snapToWindows);
+    connect(m_snapToWindows, &QCheckBox::clicked, [](bool checked) {
+        ConfigHandler().setSnapToWindows(checked);
+    });
+}
+
+void GeneralConf::initMagneticSelection()
+{
+    m_magneticSelection =
+      new QCheckBox(tr("Snap the selection to image edges"), this);
+    m_magneticSelection->setToolTip(
+      tr("The sides of the selection stick to the edges found in the "
+         "screenshot while resizing it"));
+    m_scrollAreaLayout->addWidget(m_magneticSelection);
+    connect(m_magneticSelection, &QCheckBox::clicked, [](bool checked) {
+        ConfigHandler().setMagneticSelection(checked);
+    });
+}
+
 void GeneralConf::initShowSelectionGeometry()
 {
     auto* tobox = new QHBoxLayout();
@@ -1206,6 +1233,51 @@ void GeneralConf::initJpegQuality()
             &GeneralConf::setJpegQuality);
 }
 
+void GeneralConf::initPngCompressionLevel()
+{
+    auto* tobox = new QHBoxLayout();
+
+    int level = ConfigHandler().value("pngCompressionLevel").toInt();
+    m_pngCompressionLevel = new QSpinBox();
+    m_pngCompressionLevel->setRange(0, 9);
+    m_pngCompressionLevel->setToolTip(
+      tr("Compression level of 0-9; Higher number is smaller file size and "
+         "slower saving"));
+    m_pngCompressionLevel->setValue(level);
+    tobox->addWidget(m_pngCompressionLevel);
+    tobox->addWidget(new QLabel(tr("PNG Compression Level")));
+
+    m_scrollAreaLayout->addLayout(tobox);
+    connect(m_pngCompressionLevel,
+            static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this,
+            &GeneralConf::setPngCompressionLevel);
+}
+
+void GeneralConf::initEncodingPreset()
+{
+    auto* tobox = new QHBoxLayout();
+
+    m_encodingPreset = new QComboBox(this);
+    m_encodingPreset->addItem(tr("Fastest"), "fastest");
+    m_encodingPreset->addItem(tr("Balanced"), "balanced");
+    m_encodingPreset->addItem(tr("Smallest"), "smallest");
+    m_encodingPreset->setToolTip(
+      tr("Fastest and Smallest compress PNG at level 1 and 9, Balanced at "
+         "the PNG compression level"));
+    m_encodingPreset->setCurrentIndex(
+      m_encodingPreset->findData(ConfigHandler().encodingPreset()));
+    tobox->addWidget(m_encodingPreset);
+    tobox->addWidget(new QLabel(tr("Encoding Speed")));
+
+    m_scrollAreaLayout->addLayout(tobox);
+    connect(
+      m_encodingPreset,
+      static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+      this,
+      &GeneralConf::setEncodingPreset);
+}
+
 void GeneralConf::setSelGeoHideTime(int v)
 {
     ConfigHandler().setValue("showSelectionGeometryHideTime", v);
@@ -1216,6 +1288,17 @@ void GeneralConf::setJpegQuality(int v)
     ConfigHandler().setJpegQuality(v);
 }
 
+void GeneralConf::setPngCompressionLevel(int v)
+{
+    ConfigHandler().setPngCompressionLevel(v);
+}
+
+void GeneralConf::setEncodingPreset(int index)
+{
+    ConfigHandler().setEncodingPreset(
+      m_encodingPreset->itemData(index).toString());
+}
+
 void GeneralConf::setGeometryLocation(int index)
 {
     ConfigHandler().setValue("showSelectionGeometry",
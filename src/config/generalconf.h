@@ -63,6 +63,8 @@ private slots:
     void setGeometryLocation(int index);
     void setSelGeoHideTime(int v);
     void setJpegQuality(int v);
+    void setPngCompressionLevel(int v);
+    void setEncodingPreset(int index);
 private:
     const QString chooseFolder(const QString& currentPath = "");
 
@@ -88,6 +90,8 @@ private:
     void initShowStartupLaunchMessage();
     void initShowTrayIcon();
     void initSquareMagnifier();
+    void initSnapToWindows();
+    void initMagneticSelection();
     void initUndoLimit();
     void initUploadWithoutConfirmation();
     void initUseJpgForClipboard();
@@ -97,6 +101,8 @@ private:
     void initSaveLastRegion();
     void initShowSelectionGeometry();
     void initJpegQuality();
+    void initPngCompressionLevel();
+    void initEncodingPreset();
 
     void _updateComponents(bool allowEmptySavePath);
 
@@ -148,11 +154,15 @@ private:
     QCheckBox* m_predefinedColorPaletteLarge;
     QCheckBox* m_showMagnifier;
     QCheckBox* m_squareMagnifier;
+    QCheckBox* m_snapToWindows;
+    QCheckBox* m_magneticSelection;
     QCheckBox* m_copyOnDoubleClick;
     QCheckBox* m_showSelectionGeometry;
     QComboBox* m_selectGeometryLocation;
     QSpinBox* m_xywhTimeout;
     QSpinBox* m_jpegQuality;
+    QSpinBox* m_pngCompressionLevel;
+    QComboBox* m_encodingPreset;
     QComboBox* m_selectDisplay;
     QComboBox* m_selectPlatform;
     QLabel* m_flowinityErrorMessage;
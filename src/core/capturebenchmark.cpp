@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "capturebenchmark.h"
+#include "abstractlogger.h"
+#include "src/core/capturerequest.h"
+#include "src/core/flameshot.h"
+#include "src/utils/confighandler.h"
+#include "src/utils/pngwriter.h"
+#include "src/utils/qoiwriter.h"
+#include "src/utils/screengrabber.h"
+#include "src/utils/screenshotsaver.h"
+#include <QApplication>
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QScreen>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#if defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+#define DEFAULT_ITERATIONS 20
+
+namespace {
+
+// Reset the peak resident memory of the process, only possible on Linux
+// (>= 4.0), elsewhere the peak of the whole run is reported
+void resetPeakMemory()
+{
+#if defined(Q_OS_LINUX)
+    QFile clearRefs(QStringLiteral("/proc/self/clear_refs"));
+    if (clearRefs.open(QIODevice::WriteOnly)) {
+        clearRefs.write("5");
+    }
+#endif
+}
+
+// Peak resident memory in KiB, -1 when unknown
+qint64 peakMemory()
+{
+#if defined(Q_OS_LINUX)
+    QFile status(QStringLiteral("/proc/self/status"));
+    if (status.open(QIODevice::ReadOnly)) {
+        for (const QByteArray& line : status.readAll().split('\n')) {
+            if (line.startsWith("VmHWM:")) {
+                return line.mid(6).trimmed().split(' ').first().toLongLong();
+            }
+        }
+    }
+#endif
+#if defined(Q_OS_UNIX)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#if defined(Q_OS_MACOS)
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+    return -1;
+}
+
+// Run the asynchronous grab `grab` until it calls back, a portal capture only
+// finishes in the event loop
+QPixmap waitForGrab(
+  bool& ok,
+  const std::function<void(const ScreenGrabber::Callback&)>& grab)
+{
+    bool done = false;
+    QPixmap result;
+    grab([&](bool grabbed, const QPixmap& pixmap) {
+        ok = grabbed;
+        result = pixmap;
+        done = true;
+    });
+    while (!done) {
+        qApp->processEvents(QEventLoop::WaitForMoreEvents);
+    }
+    return result;
+}
+
+// Nearest-rank percentile of sorted samples, in milliseconds
+double percentile(const QVector<qint64>& sorted, double p)
+{
+    const int rank = qMax(1, static_cast<int>(std::ceil(p * sorted.size())));
+    return sorted.at(rank - 1) / 1000000.0;
+}
+
+} // namespace
+
+CaptureBenchmark::CaptureBenchmark(int iterations)
+  : m_iterations(iterations > 0 ? iterations : DEFAULT_ITERATIONS)
+{}
+
+int CaptureBenchmark::run()
+{
+    if (!m_directory.isValid()) {
+        AbstractLogger::error(AbstractLogger::Stderr)
+          << QStringLiteral("Unable to create a temporary directory");
+        return 1;
+    }
+    ScreenGrabber grabber;
+    bool ok = true;
+    const auto grabDesktop = [&](const QRect& region) {
+        return waitForGrab(ok, [&](const ScreenGrabber::Callback& done) {
+            grabber.grabEntireDesktopAsync(region, qApp, done);
+        });
+    };
+    QPixmap capture = grabDesktop(QRect());
+    if (!ok || capture.isNull()) {
+        AbstractLogger::error(AbstractLogger::Stderr)
+          << QStringLiteral("Unable to capture the screen");
+        return 1;
+    }
+    QScreen* screen = QGuiApplication::primaryScreen();
+    const QRect region(QPoint(0, 0), capture.size() / 2);
+
+    measure(QStringLiteral("grab"), [&]() { capture = grabDesktop(QRect()); });
+    measure(QStringLiteral("grab_screen"), [&]() {
+        waitForGrab(ok, [&](const ScreenGrabber::Callback& done) {
+            grabber.grabScreenAsync(screen, QRect(), qApp, done);
+        });
+    });
+    measure(QStringLiteral("grab_region"), [&]() { grabDesktop(region); });
+
+    QImage image;
+    measure(QStringLiteral("convert"), [&]() { image = capture.toImage(); });
+    QByteArray encoded;
+    measure(QStringLiteral("encode"), [&]() {
+        encoded.clear();
+        QBuffer buffer(&encoded);
+        buffer.open(QIODevice::WriteOnly);
+        capture.save(&buffer, "PNG");
+    });
+    // The encoder used by the exports, in strips over all the cores
+    const int level = ConfigHandler().pngCompressionLevel();
+    measure(QStringLiteral("encode_png"),
+            [&]() { encoded = PngWriter::encode(image, level); });
+    QByteArray qoi;
+    measure(QStringLiteral("encode_qoi"),
+            [&]() { qoi = QoiWriter::encode(image); });
+    const QString path = m_directory.filePath(QStringLiteral("capture.png"));
+    measure(QStringLiteral("write"), [&]() {
+        QFile file(path);
+        file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        file.write(encoded);
+    });
+    measure(QStringLiteral("clipboard"), [&]() { saveToClipboard(capture); });
+
+    // The commands end to end, as run by the daemon, until the file is
+    // written in the background
+    Flameshot* flameshot = Flameshot::instance();
+    const auto waitForExports = [flameshot]() {
+        while (flameshot->isGrabbing() || flameshot->isExporting()) {
+            qApp->processEvents(QEventLoop::WaitForMoreEvents);
+        }
+    };
+    CaptureRequest fullRequest(CaptureRequest::FULLSCREEN_MODE);
+    fullRequest.addSaveTask(m_directory.filePath(QStringLiteral("full.png")));
+    measure(QStringLiteral("full"), [&]() {
+        flameshot->full(fullRequest);
+        waitForExports();
+    });
+    CaptureRequest screenRequest(CaptureRequest::SCREEN_MODE);
+    screenRequest.addSaveTask(
+      m_directory.filePath(QStringLiteral("screen.png")));
+    measure(QStringLiteral("screen"), [&]() {
+        flameshot->screen(screenRequest, 0);
+        waitForExports();
+    });
+
+    QTextStream(stdout) << QJsonDocument(results()).toJson(
+                             QJsonDocument::Compact)
+                        << '\n';
+    return 0;
+}
+
+void CaptureBenchmark::measure(const QString& name,
+                               const std::function<void()>& function)
+{
+    Stage stage{ name, {}, 0 };
+    // Warm up the caches, connections and thread pools first
+    function();
+    qApp->processEvents();
+    resetPeakMemory();
+    QElapsedTimer timer;
+    for (int i = 0; i < m_iterations; ++i) {
+        timer.start();
+        function();
+        stage.samples.append(timer.nsecsElapsed());
+        // Pending events (deferred deletions, clipboard requests) are not
+        // part of the stage
+        qApp->processEvents();
+    }
+    stage.peakMemory = peakMemory();
+    std::sort(stage.samples.begin(), stage.samples.end());
+    m_stages.append(stage);
+}
+
+QJsonObject CaptureBenchmark::environment() const
+{
+    QJsonArray screens;
+    for (QScreen* const screen : QGuiApplication::screens()) {
+        const QRect geometry = screen->geometry();
+        screens.append(QJsonObject{
+          { QStringLiteral("x"), geometry.x() },
+          { QStringLiteral("y"), geometry.y() },
+          { QStringLiteral("width"), geometry.width() },
+          { QStringLiteral("height"), geometry.height() },
+          { QStringLiteral("dpr"), screen->devicePixelRatio() } });
+    }
+    return QJsonObject{
+        { QStringLiteral("version"), QStringLiteral(APP_VERSION) },
+        { QStringLiteral("qt"), QString::fromLatin1(qVersion()) },
+        { QStringLiteral("platform"), QGuiApplication::platformName() },
+        { QStringLiteral("screens"), screens },
+        { QStringLiteral("iterations"), m_iterations },
+    };
+}
+
+QJsonObject CaptureBenchmark::results() const
+{
+    QJsonArray stages;
+    for (const Stage& stage : m_stages) {
+        const qint64 total = std::accumulate(
+          stage.samples.begin(), stage.samples.end(), qint64(0));
+        stages.append(QJsonObject{
+          { QStringLiteral("name"), stage.name },
+          { QStringLiteral("p50_ms"), percentile(stage.samples, 0.5) },
+          { QStringLiteral("p95_ms"), percentile(stage.samples, 0.95) },
+          { QStringLiteral("mean_ms"),
+            total / 1000000.0 / stage.samples.size() },
+          { QStringLiteral("peak_rss_kb"), stage.peakMemory } });
+    }
+    return QJsonObject{ { QStringLiteral("environment"), environment() },
+                        { QStringLiteral("stages"), stages } };
+}
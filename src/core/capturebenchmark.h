@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QJsonObject>
+#include <QPixmap>
+#include <QString>
+#include <QTemporaryDir>
+#include <QVector>
+#include <functional>
+
+/**
+ * @brief Measures the latency and the memory of the capture pipeline.
+ *
+ * Built with -DFLAMESHOT_BENCHMARK=ON and started with
+ * `flameshot benchmark [iterations]`, preferably on a headless display
+ * (Xvfb, offscreen QPA) driven by tests/benchmark.sh. Every stage (grab,
+ * convert, encode, write, clipboard and the `full`/`screen` commands end to
+ * end) is run `iterations` times. The median, the 95th percentile and the
+ * peak resident memory of each stage are printed as a single line of JSON.
+ */
+class CaptureBenchmark
+{
+public:
+    explicit CaptureBenchmark(int iterations);
+
+    // Run all the stages and print the results, returns the exit code
+    int run();
+
+private:
+    struct Stage
+    {
+        QString name;
+        QVector<qint64> samples;
+        qint64 peakMemory;
+    };
+
+    void measure(const QString& name, const std::function<void()>& function);
+    QJsonObject environment() const;
+    QJsonObject results() const;
+
+    // class members
+    int m_iterations;
+    QTemporaryDir m_directory;
+    QVector<Stage> m_stages;
+};
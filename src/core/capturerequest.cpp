@@ -57,6 +57,11 @@ QRect CaptureRequest::initialSelection() const
     return m_initialSelection;
 }
 
+QPixmap CaptureRequest::screenshot() const
+{
+    return m_screenshot;
+}
+
 void CaptureRequest::addTask(CaptureRequest::ExportTask task)
 {
     if (task == SAVE) {
@@ -86,3 +91,8 @@ void CaptureRequest::setInitialSelection(const QRect& selection)
 {
     m_initialSelection = selection;
 }
+
+void CaptureRequest::setScreenshot(const QPixmap& screenshot)
+{
+    m_screenshot = screenshot;
+}
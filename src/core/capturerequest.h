@@ -43,12 +43,15 @@ public:
     CaptureMode captureMode() const;
     ExportTask tasks() const;
     QRect initialSelection() const;
+    QPixmap screenshot() const;
 
     void addTask(ExportTask task);
     void removeTask(ExportTask task);
     void addSaveTask(const QString& path = QString());
     void addPinTask(const QRect& pinWindowGeometry);
     void setInitialSelection(const QRect& selection);
+    // Edit this capture instead of grabbing the screen
+    void setScreenshot(const QPixmap& screenshot);
 
 private:
     CaptureMode m_mode;
@@ -57,6 +60,7 @@ private:
     ExportTask m_tasks;
     QVariant m_data;
     QRect m_pinWindowGeometry, m_initialSelection;
+    QPixmap m_screenshot;
 
     CaptureRequest() {}
 };
@@ -14,6 +14,7 @@
 #include "src/core/qguiappcurrentscreen.h"
 #include "src/tools/imgupload/imguploadermanager.h"
 #include "src/utils/confighandler.h"
+#include "src/utils/filenamehandler.h"
 #include "src/utils/screengrabber.h"
 #include "src/widgets/capture/capturewidget.h"
 #include "src/widgets/capturelauncher.h"
@@ -26,7 +27,9 @@
 #include <QDesktopWidget>
 #include <QFile>
 #include <QMessageBox>
+#include <QRunnable>
 #include <QThread>
+#include <QThreadPool>
 #include <QTimer>
 #include <QVersionNumber>
 #include <QNetworkReply>
@@ -38,6 +41,8 @@
 Flameshot::Flameshot()
   : m_captureWindow(nullptr)
   , m_haveExternalWidget(false)
+  , m_pendingExports(0)
+  , m_grabbing(false)
 #if defined(Q_OS_MACOS)
   , m_HotkeyScreenshotCapture(nullptr)
   , m_HotkeyScreenshotHistory(nullptr)
@@ -77,7 +82,7 @@ Flameshot* Flameshot::instance()
 
 CaptureWidget* Flameshot::gui(const CaptureRequest& req)
 {
-    if (!resolveAnyConfigErrors()) {
+    if (!resolveAnyConfigErrors() || rejectWhileGrabbing()) {
         return nullptr;
     }
 
@@ -113,7 +118,30 @@ CaptureWidget* Flameshot::gui(const CaptureRequest& req)
             return nullptr;
         }
 
+        ScreenGrabber grabber;
+        if (req.screenshot().isNull() && grabber.portalBackend()) {
+            // The editor is opened once the portal answers
+            m_grabbing = true;
+            grabber.grabEntireDesktopAsync(
+              QRect(), this, [this, req](bool ok, const QPixmap& p) {
+                  m_grabbing = false;
+                  if (!ok) {
+                      emit captureFailed();
+                      isRequested = false;
+                      return;
+                  }
+                  CaptureRequest grabbed(req);
+                  grabbed.setScreenshot(p);
+                  gui(grabbed);
+              });
+            return nullptr;
+        }
+
         m_captureWindow = new CaptureWidget(req);
+        connect(m_captureWindow, &QObject::destroyed, this, [this]() {
+            emit captureWindowOpen(false);
+        });
+        emit captureWindowOpen(true);
 
 #ifdef Q_OS_WIN
         m_captureWindow->show();
@@ -138,11 +166,10 @@ CaptureWidget* Flameshot::gui(const CaptureRequest& req)
 
 void Flameshot::screen(CaptureRequest req, const int screenNumber)
 {
-    if (!resolveAnyConfigErrors()) {
+    if (!resolveAnyConfigErrors() || rejectWhileGrabbing()) {
         return;
     }
 
-    bool ok = true;
     QScreen* screen;
 
     if (screenNumber < 0) {
@@ -156,50 +183,66 @@ void Flameshot::screen(CaptureRequest req, const int screenNumber)
     } else {
         screen = qApp->screens()[screenNumber];
     }
-    QPixmap p(ScreenGrabber().grabScreen(screen, ok));
-    if (ok) {
-        QRect geometry = ScreenGrabber().screenGeometry(screen);
-        QRect region = req.initialSelection();
-        if (region.isNull()) {
-            region = ScreenGrabber().screenGeometry(screen);
-        } else {
-            QRect screenGeom = ScreenGrabber().screenGeometry(screen);
-            screenGeom.moveTopLeft({ 0, 0 });
-            region = region.intersected(screenGeom);
-            p = p.copy(region);
-        }
-        if (req.tasks() & CaptureRequest::PIN) {
-            // change geometry for pin task
-            req.addPinTask(region);
+    ScreenGrabber grabber;
+    QRect geometry = grabber.screenGeometry(screen);
+    QRect region = req.initialSelection();
+    if (!region.isNull()) {
+        QRect screenGeom = geometry;
+        screenGeom.moveTopLeft({ 0, 0 });
+        region = region.intersected(screenGeom);
+        if (region.isEmpty()) {
+            AbstractLogger() << QObject::tr(
+              "Requested region is outside of the screen");
+            emit captureFailed();
+            isRequested = false;
+            return;
         }
-        exportCapture(p, geometry, req);
-        isRequested = false;
-    } else {
-        emit captureFailed();
-        isRequested = false;
     }
+    // Only the requested region is grabbed
+    m_grabbing = true;
+    grabber.grabScreenAsync(
+      screen,
+      region,
+      this,
+      [this, req, geometry, region](bool ok, const QPixmap& p) mutable {
+          m_grabbing = false;
+          if (ok) {
+              if (region.isNull()) {
+                  region = geometry;
+              }
+              if (req.tasks() & CaptureRequest::PIN) {
+                  // change geometry for pin task
+                  req.addPinTask(region);
+              }
+              exportCapture(p, geometry, req);
+              isRequested = false;
+          } else {
+              emit captureFailed();
+              isRequested = false;
+          }
+      });
 }
 
 void Flameshot::full(const CaptureRequest& req)
 {
-    if (!resolveAnyConfigErrors()) {
+    if (!resolveAnyConfigErrors() || rejectWhileGrabbing()) {
         return;
     }
 
-    bool ok = true;
-    QPixmap p(ScreenGrabber().grabEntireDesktop(ok));
-    QRect region = req.initialSelection();
-    if (!region.isNull()) {
-        p = p.copy(region);
-    }
-    if (ok) {
-        QRect selection; // `flameshot full` does not support --selection
-        exportCapture(p, selection, req);
-        isRequested = false;
-    } else {
-        emit captureFailed();
-        isRequested = false;
-    }
+    // Only the requested region is grabbed
+    m_grabbing = true;
+    ScreenGrabber().grabEntireDesktopAsync(
+      req.initialSelection(), this, [this, req](bool ok, const QPixmap& p) {
+          m_grabbing = false;
+          if (ok) {
+              QRect selection; // `flameshot full` does not support --selection
+              exportCapture(p, selection, req);
+              isRequested = false;
+          } else {
+              emit captureFailed();
+              isRequested = false;
+          }
+      });
 }
 
 void Flameshot::launcher()
@@ -279,6 +322,22 @@ Flameshot::Origin Flameshot::origin()
     return m_origin;
 }
 
+/**
+ * @brief Refuse a new capture while another one waits for the portal.
+ * @return Whether the capture was refused.
+ */
+bool Flameshot::rejectWhileGrabbing()
+{
+    if (!m_grabbing) {
+        return false;
+    }
+    AbstractLogger::info()
+      << tr("Another capture is waiting for the screen, try again later");
+    emit captureFailed();
+    isRequested = false;
+    return true;
+}
+
 /**
  * @brief Prompt the user to resolve config errors if necessary.
  * @return Whether errors were resolved.
@@ -352,6 +411,81 @@ void Flameshot::requestCapture(const CaptureRequest& request)
 
 static int openWindowCount = 0;
 
+// Whether the user agrees to upload the capture, unless that isn't asked
+static bool confirmUpload()
+{
+    if (ConfigHandler().uploadWithoutConfirmation()) {
+        return true;
+    }
+    auto* dialog = new ImgUploadDialog();
+    return dialog->exec() != QDialog::Rejected;
+}
+
+struct Flameshot::ExportJob
+{
+    int tasks = 0;
+    // Where the capture is saved, empty for none
+    QString savePath;
+    // The save path was chosen in a dialog
+    bool savePathChosen = false;
+    int jpegQuality = -1;
+    bool saved = false;
+    QString saveError;
+    // Formats the clipboard and the upload will ask for
+    QVector<QByteArray> formats;
+};
+
+class Flameshot::EncodeTask : public QRunnable
+{
+public:
+    EncodeTask(Flameshot* flameshot,
+               const EncodedCapture& capture,
+               const ExportJob& job)
+      : m_flameshot(flameshot)
+      , m_capture(capture)
+      , m_job(job)
+    {}
+
+    void run() override
+    {
+        if (m_job.tasks & CaptureRequest::PRINT_RAW) {
+            QFile file;
+            file.open(stdout, QIODevice::WriteOnly);
+
+            file.write(m_capture.encoded("png"));
+            file.close();
+        }
+        if (!m_job.savePath.isEmpty()) {
+            m_job.saved = writeToFilesystem(
+              m_capture, m_job.savePath, m_job.jpegQuality, m_job.saveError);
+        }
+        for (const QByteArray& format : qAsConst(m_job.formats)) {
+            m_capture.encodedAs(format, m_job.jpegQuality);
+        }
+
+        // The capture is handed back, its pixmap must die in the GUI thread
+        Flameshot* flameshot = m_flameshot;
+        QMetaObject::invokeMethod(
+          flameshot,
+          [flameshot, capture = std::move(m_capture), job = m_job]() {
+              flameshot->finishExport(capture, job);
+          },
+          Qt::QueuedConnection);
+    }
+
+private:
+    Flameshot* m_flameshot;
+    EncodedCapture m_capture;
+    ExportJob m_job;
+};
+
+/**
+ * @brief Export the capture to the sinks of `req`.
+ *
+ * Only what needs the user or is immediate is done here. Encoding the
+ * capture and writing it happen in the global thread pool, the clipboard and
+ * the upload follow in `finishExport` with the encodings ready.
+ */
 void Flameshot::exportCapture(const QPixmap& capture,
                               QRect& selection,
                               const CaptureRequest& req)
@@ -359,6 +493,7 @@ void Flameshot::exportCapture(const QPixmap& capture,
     using CR = CaptureRequest;
     int tasks = req.tasks(), mode = req.captureMode();
     QString path = req.path();
+    ConfigHandler config;
 
     if (tasks & CR::PRINT_GEOMETRY) {
         QByteArray byteArray;
@@ -368,27 +503,22 @@ void Flameshot::exportCapture(const QPixmap& capture,
           << selection.x() << "+" << selection.y() << "\n";
     }
 
-    if (tasks & CR::PRINT_RAW) {
-        QByteArray byteArray;
-        QBuffer buffer(&byteArray);
-        capture.save(&buffer, "PNG");
-        QFile file;
-        file.open(stdout, QIODevice::WriteOnly);
-
-        file.write(byteArray);
-        file.close();
-    }
-
+    ExportJob job;
+    job.tasks = tasks;
+    job.jpegQuality = config.jpegQuality();
     if (tasks & CR::SAVE) {
-        if (req.path().isEmpty()) {
-            saveToFilesystemGUI(capture);
-        } else {
-            saveToFilesystem(capture, path);
-        }
+        job.savePathChosen = path.isEmpty();
+        job.savePath = job.savePathChosen
+                         ? chooseSavePath()
+                         : FileNameHandler().properScreenshotPath(
+                             path, config.saveAsFileExtension());
     }
-
     if (tasks & CR::COPY) {
-        FlameshotDaemon::copyToClipboard(capture);
+        // The format the clipboard offers first
+        job.formats.append(clipboardFormat().toLatin1());
+    }
+    if (tasks & CR::UPLOAD) {
+        job.formats.append(config.uploadFormat().toLatin1());
     }
 
     if (tasks & CR::PIN) {
@@ -399,15 +529,43 @@ void Flameshot::exportCapture(const QPixmap& capture,
         }
     }
 
-    if (tasks & CR::UPLOAD) {
-        if (!ConfigHandler().uploadWithoutConfirmation()) {
-            auto* dialog = new ImgUploadDialog();
-            if (dialog->exec() == QDialog::Rejected) {
-                return;
-            }
+    ++m_pendingExports;
+    // The sinks share the encoded files, e.g. the PNG printed, saved and
+    // uploaded is only encoded once
+    QThreadPool::globalInstance()->start(
+      new EncodeTask(this, EncodedCapture(capture), job));
+}
+
+bool Flameshot::isExporting() const
+{
+    return m_pendingExports > 0;
+}
+
+bool Flameshot::isGrabbing() const
+{
+    return m_grabbing;
+}
+
+void Flameshot::finishExport(const EncodedCapture& encoded,
+                             const ExportJob& job)
+{
+    using CR = CaptureRequest;
+    int tasks = job.tasks;
+
+    if (!job.savePath.isEmpty()) {
+        if (job.savePathChosen) {
+            notifySavedGUI(job.saved, job.savePath, job.saveError);
+        } else {
+            notifySaved(job.saved, job.savePath, job.saveError);
         }
+    }
 
-        ImgUploaderBase* widget = ImgUploaderManager().uploader(capture);
+    if (tasks & CR::COPY) {
+        FlameshotDaemon::copyToClipboard(encoded);
+    }
+
+    if ((tasks & CR::UPLOAD) && confirmUpload()) {
+        ImgUploaderBase* widget = ImgUploaderManager().uploader(encoded);
 
         openWindowCount++;
 
@@ -449,8 +607,11 @@ void Flameshot::exportCapture(const QPixmap& capture,
     }
 
     if (!(tasks & CR::UPLOAD)) {
-        emit captureTaken(capture);
+        emit captureTaken(encoded.pixmap());
     }
+
+    --m_pendingExports;
+    emit exportFinished(job.savePath.isEmpty() || job.saved);
 }
 
 void Flameshot::setExternalWidget(bool b)
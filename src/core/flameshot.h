@@ -9,6 +9,7 @@
 #include <QVersionNumber>
 
 class CaptureWidget;
+class EncodedCapture;
 class ConfigWindow;
 class InfoWindow;
 class CaptureLauncher;
@@ -50,10 +51,18 @@ public:
     static Origin origin();
     void setExternalWidget(bool b);
     bool haveExternalWidget();
+    // Whether exported captures are still being encoded or written
+    bool isExporting() const;
+    // Whether a capture is waiting for the screen to be grabbed
+    bool isGrabbing() const;
 
 signals:
     void captureTaken(QPixmap p);
     void captureFailed();
+    // Emitted once an export is done, `ok` is false when saving failed
+    void exportFinished(bool ok);
+    // Emitted when the capture editor is opened and when it is closed
+    void captureWindowOpen(bool open);
 
 public slots:
     void requestCapture(const CaptureRequest& request);
@@ -62,12 +71,21 @@ public slots:
                        const CaptureRequest& req);
 
 private:
+    struct ExportJob;
+    class EncodeTask;
+
     Flameshot();
     bool resolveAnyConfigErrors();
+    bool rejectWhileGrabbing();
+    void finishExport(const EncodedCapture& encoded, const ExportJob& job);
 
     // class members
     static Origin m_origin;
     bool m_haveExternalWidget;
+    int m_pendingExports;
+    // A portal capture can wait for the permission of the user, no other
+    // capture starts in the meantime
+    bool m_grabbing;
 
     QPointer<CaptureWidget> m_captureWindow;
     QPointer<InfoWindow> m_infoWindow;
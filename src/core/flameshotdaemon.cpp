@@ -4,6 +4,7 @@
 #include "confighandler.h"
 #include "flameshot.h"
 #include "pinwidget.h"
+#include "retroactivebuffer.h"
 #include "screenshotsaver.h"
 #include "src/utils/globalvalues.h"
 #include "src/widgets/capture/capturewidget.h"
@@ -13,6 +14,7 @@
 #include <QClipboard>
 #include <QDBusConnection>
 #include <QDBusMessage>
+#include <QDBusReply>
 #include <QPixmap>
 #include <QRect>
 
@@ -66,6 +68,7 @@ FlameshotDaemon::FlameshotDaemon()
   , m_hostingClipboard(false)
   , m_clipboardSignalBlocked(false)
   , m_trayIcon(nullptr)
+  , m_retroactiveBuffer(nullptr)
 #if !defined(DISABLE_UPDATE_CHECKER)
   , m_networkCheckUpdates(nullptr)
   , m_showCheckAppUpdateStatus(false)
@@ -94,6 +97,18 @@ FlameshotDaemon::FlameshotDaemon()
                 m_persist = !config.autoCloseIdleDaemon();
             });
 #endif
+    // Exports still being written keep the daemon alive
+    connect(Flameshot::instance(),
+            &Flameshot::exportFinished,
+            this,
+            &FlameshotDaemon::quitIfIdle);
+    enableRetroactiveCapture(ConfigHandler().retroactiveCapture());
+    connect(ConfigHandler::getInstance(),
+            &ConfigHandler::fileChanged,
+            this,
+            [this]() {
+                enableRetroactiveCapture(ConfigHandler().retroactiveCapture());
+            });
 
 #if !defined(DISABLE_UPDATE_CHECKER)
     if (ConfigHandler().checkForUpdates()) {
@@ -128,7 +143,7 @@ void FlameshotDaemon::createPin(const QPixmap& capture, QRect geometry)
     call(m);
 }
 
-void FlameshotDaemon::copyToClipboard(const QPixmap& capture)
+void FlameshotDaemon::copyToClipboard(const EncodedCapture& capture)
 {
     if (instance()) {
         instance()->attachScreenshotToClipboard(capture);
@@ -138,11 +153,9 @@ void FlameshotDaemon::copyToClipboard(const QPixmap& capture)
     QDBusMessage m =
       createMethodCall(QStringLiteral("attachScreenshotToClipboard"));
 
-    QByteArray data;
-    QDataStream stream(&data, QIODevice::WriteOnly);
-    stream << capture;
-
-    m << data;
+    // Sent as PNG, which the daemon reuses for the clipboard and the file
+    // saved after copying, instead of encoding it again
+    m << capture.encoded("png");
     call(m);
 }
 
@@ -162,6 +175,32 @@ void FlameshotDaemon::copyToClipboard(const QString& text,
     sessionBus.call(m);
 }
 
+/**
+ * @brief Open the capture editor on the desktop as it was `secondsAgo` seconds
+ * ago, from the recent captures kept by the daemon (`retroactiveCapture`).
+ * @return Whether the editor was opened, the reason is reported otherwise
+ */
+bool FlameshotDaemon::openRetroactiveCapture(int secondsAgo)
+{
+    QString error;
+    if (instance()) {
+        error = instance()->showRetroactiveCapture(secondsAgo);
+    } else {
+        QDBusMessage m =
+          createMethodCall(QStringLiteral("captureRetroactive"));
+        m << secondsAgo;
+        QDBusConnection sessionBus = QDBusConnection::sessionBus();
+        checkDBusConnection(sessionBus);
+        const QDBusReply<QString> reply = sessionBus.call(m);
+        error = reply.isValid() ? reply.value() : reply.error().message();
+    }
+    if (!error.isEmpty()) {
+        AbstractLogger::error() << error;
+        return false;
+    }
+    return true;
+}
+
 /**
  * @brief Is this instance of flameshot hosting any windows as a daemon?
  */
@@ -183,7 +222,8 @@ void FlameshotDaemon::sendTrayNotification(const QString& text,
 #if !defined(DISABLE_UPDATE_CHECKER)
 void FlameshotDaemon::showUpdateNotificationIfAvailable(CaptureWidget* widget)
 {
-    if (!m_appLatestUrl.isEmpty() &&
+    // No editor is open yet while the portal is waited for
+    if (widget != nullptr && !m_appLatestUrl.isEmpty() &&
         ConfigHandler().ignoreUpdateToVersion().compare(m_appLatestVersion) <
           0) {
         widget->showAppUpdateNotification(m_appLatestVersion, m_appLatestUrl);
@@ -255,6 +295,13 @@ void FlameshotDaemon::quitIfIdle()
     if (m_persist) {
         return;
     }
+    // Recent captures are only kept while the daemon runs
+    if (m_retroactiveBuffer != nullptr) {
+        return;
+    }
+    if (Flameshot::instance()->isExporting()) {
+        return;
+    }
     if (!m_hostingClipboard && m_widgets.isEmpty()) {
         qApp->exit(0);
     }
@@ -275,7 +322,8 @@ void FlameshotDaemon::attachPin(const QPixmap& pixmap, QRect geometry)
     pinWidget->activateWindow();
 }
 
-void FlameshotDaemon::attachScreenshotToClipboard(const QPixmap& pixmap)
+void FlameshotDaemon::attachScreenshotToClipboard(
+  const EncodedCapture& capture)
 {
     m_hostingClipboard = true;
     QClipboard* clipboard = QApplication::clipboard();
@@ -283,10 +331,26 @@ void FlameshotDaemon::attachScreenshotToClipboard(const QPixmap& pixmap)
     // This variable is necessary because the signal doesn't get blocked on
     // windows for some reason
     m_clipboardSignalBlocked = true;
-    saveToClipboard(pixmap);
+    saveToClipboard(capture);
     clipboard->blockSignals(false);
 }
 
+QString FlameshotDaemon::showRetroactiveCapture(int secondsAgo)
+{
+    if (m_retroactiveBuffer == nullptr) {
+        return tr("Recent captures are not kept, enable retroactiveCapture "
+                  "in the configuration");
+    }
+    const QPixmap screenshot = m_retroactiveBuffer->frame(secondsAgo);
+    if (screenshot.isNull()) {
+        return tr("No recent capture was recorded yet");
+    }
+    CaptureRequest req(CaptureRequest::GRAPHICAL_MODE);
+    req.setScreenshot(screenshot);
+    Flameshot::instance()->gui(req);
+    return QString();
+}
+
 // D-BUS ADAPTER METHODS
 
 void FlameshotDaemon::attachPin(const QByteArray& data)
@@ -303,11 +367,7 @@ void FlameshotDaemon::attachPin(const QByteArray& data)
 
 void FlameshotDaemon::attachScreenshotToClipboard(const QByteArray& screenshot)
 {
-    QDataStream stream(screenshot);
-    QPixmap p;
-    stream >> p;
-
-    attachScreenshotToClipboard(p);
+    attachScreenshotToClipboard(EncodedCapture::fromData(screenshot, "png"));
 }
 
 void FlameshotDaemon::attachTextToClipboard(const QString& text,
@@ -367,6 +427,36 @@ void FlameshotDaemon::enableTrayIcon(bool enable)
     }
 }
 
+void FlameshotDaemon::enableRetroactiveCapture(bool enable)
+{
+    if (enable && !RetroactiveBuffer::isSupported()) {
+        // Not repeated every time the configuration changes
+        static bool warned = false;
+        if (!warned) {
+            AbstractLogger::warning()
+              << tr("retroactiveCapture is only supported on X11");
+            warned = true;
+        }
+        enable = false;
+    }
+    if (enable) {
+        if (m_retroactiveBuffer == nullptr) {
+            m_retroactiveBuffer = new RetroactiveBuffer(this);
+            // The editor would be recorded over the desktop
+            connect(Flameshot::instance(),
+                    &Flameshot::captureWindowOpen,
+                    m_retroactiveBuffer,
+                    &RetroactiveBuffer::setPaused);
+        } else {
+            m_retroactiveBuffer->reloadConfig();
+        }
+    } else if (m_retroactiveBuffer) {
+        delete m_retroactiveBuffer;
+        m_retroactiveBuffer = nullptr;
+        quitIfIdle();
+    }
+}
+
 #if !defined(DISABLE_UPDATE_CHECKER)
 void FlameshotDaemon::handleReplyCheckUpdates(QNetworkReply* reply)
 {
@@ -4,12 +4,14 @@
 #include <QObject>
 #include <QtDBus/QDBusAbstractAdaptor>
 
+class EncodedCapture;
 class QPixmap;
 class QRect;
 class QDBusMessage;
 class QDBusConnection;
 class TrayIcon;
 class CaptureWidget;
+class RetroactiveBuffer;
 
 #if !defined(DISABLE_UPDATE_CHECKER)
 class QNetworkAccessManager;
@@ -24,9 +26,10 @@ public:
     static void start();
     static FlameshotDaemon* instance();
     static void createPin(const QPixmap& capture, QRect geometry);
-    static void copyToClipboard(const QPixmap& capture);
+    static void copyToClipboard(const EncodedCapture& capture);
     static void copyToClipboard(const QString& text,
                                 const QString& notification = "");
+    static bool openRetroactiveCapture(int secondsAgo);
     static bool isThisInstanceHostingWidgets();
 
     void sendTrayNotification(
@@ -52,7 +55,9 @@ private:
     FlameshotDaemon();
     void quitIfIdle();
     void attachPin(const QPixmap& pixmap, QRect geometry);
-    void attachScreenshotToClipboard(const QPixmap& pixmap);
+    void attachScreenshotToClipboard(const EncodedCapture& capture);
+    // Empty on success, the reason of the failure otherwise
+    QString showRetroactiveCapture(int secondsAgo);
 
     void attachPin(const QByteArray& data);
     void attachScreenshotToClipboard(const QByteArray& screenshot);
@@ -61,6 +66,7 @@ private:
 
     void initTrayIcon();
     void enableTrayIcon(bool enable);
+    void enableRetroactiveCapture(bool enable);
 
 private:
     static QDBusMessage createMethodCall(const QString& method);
@@ -72,6 +78,7 @@ private:
     bool m_clipboardSignalBlocked;
     QList<QWidget*> m_widgets;
     TrayIcon* m_trayIcon;
+    RetroactiveBuffer* m_retroactiveBuffer;
 
 #if !defined(DISABLE_UPDATE_CHECKER)
     QString m_appLatestUrl;
@@ -39,4 +39,9 @@ void FlameshotDBusAdapter::captureScreen(const QString& captureMode)
     }
     Flameshot::instance()->requestCapture(
       CaptureRequest::CaptureMode(captureModeInt));
-}
\ No newline at end of file
+}
+
+QString FlameshotDBusAdapter::captureRetroactive(int secondsAgo)
+{
+    return FlameshotDaemon::instance()->showRetroactiveCapture(secondsAgo);
+}
@@ -20,4 +20,6 @@ public slots:
                                          const QString& notification);
     Q_NOREPLY void attachPin(const QByteArray& data);
     Q_NOREPLY void captureScreen(const QString& captureMode);
+    // Empty on success, the reason of the failure otherwise
+    QString captureRetroactive(int secondsAgo);
 };
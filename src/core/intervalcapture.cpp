@@ -0,0 +1,243 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "intervalcapture.h"
+#include "abstractlogger.h"
+#include "src/utils/confighandler.h"
+#include "src/utils/filenamehandler.h"
+#include <QCursor>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QRunnable>
+#include <cstring>
+
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#endif
+
+// Frames waiting to be saved before new ones are dropped
+#define MAX_PENDING_FRAMES 8
+
+namespace {
+
+// Whether `a` and `b` have the same pixels. They are compared rather than
+// hashed, a collision would link a frame that changed to the previous one.
+bool samePixels(const QImage& a, const QImage& b)
+{
+    if (a.size() != b.size() || a.format() != b.format()) {
+        return false;
+    }
+    const size_t length = static_cast<size_t>(a.width()) * a.depth() / 8;
+    for (int y = 0; y < a.height(); ++y) {
+        if (std::memcmp(a.constScanLine(y), b.constScanLine(y), length) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Hard link `link` to `target`, copy it where that is not possible
+bool linkFile(const QString& target, const QString& link)
+{
+#if defined(Q_OS_UNIX)
+    if (::link(QFile::encodeName(target).constData(),
+               QFile::encodeName(link).constData()) == 0) {
+        return true;
+    }
+#elif defined(Q_OS_WIN)
+    if (CreateHardLinkW(reinterpret_cast<LPCWSTR>(link.utf16()),
+                        reinterpret_cast<LPCWSTR>(target.utf16()),
+                        nullptr)) {
+        return true;
+    }
+#endif
+    return QFile::copy(target, link);
+}
+
+} // namespace
+
+class IntervalCapture::FrameTask : public QRunnable
+{
+public:
+    FrameTask(IntervalCapture* capture, const QImage& image)
+      : m_capture(capture)
+      , m_image(image)
+    {}
+
+    void run() override
+    {
+        m_capture->saveFrame(m_image);
+        m_capture->m_pending.deref();
+    }
+
+private:
+    IntervalCapture* m_capture;
+    QImage m_image;
+};
+
+IntervalCapture::IntervalCapture(const CaptureRequest& req,
+                                 int interval,
+                                 int count,
+                                 QObject* parent)
+  : QObject(parent)
+  , m_req(req)
+  , m_count(count)
+  , m_taken(0)
+  , m_dropped(0)
+  , m_screen(nullptr)
+  , m_region(req.initialSelection())
+  , m_grabbing(false)
+{
+    m_pool.setMaxThreadCount(1);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setInterval(interval);
+    connect(&m_timer, &QTimer::timeout, this, &IntervalCapture::capture);
+}
+
+IntervalCapture::~IntervalCapture()
+{
+    m_timer.stop();
+    m_pool.waitForDone();
+}
+
+bool IntervalCapture::start()
+{
+    if (m_req.captureMode() == CaptureRequest::SCREEN_MODE) {
+        const int number = m_req.data().toInt();
+        if (number < 0) {
+            m_screen = qApp->screenAt(QCursor::pos());
+        } else if (number < qApp->screens().count()) {
+            m_screen = qApp->screens().at(number);
+        }
+        if (m_screen == nullptr) {
+            AbstractLogger::error()
+              << tr("Requested screen exceeds screen count");
+            return false;
+        }
+        if (!m_region.isNull()) {
+            QRect screenGeom = m_grabber.screenGeometry(m_screen);
+            screenGeom.moveTopLeft({ 0, 0 });
+            m_region = m_region.intersected(screenGeom);
+            if (m_region.isEmpty()) {
+                AbstractLogger::error()
+                  << tr("Requested region is outside of the screen");
+                return false;
+            }
+        }
+    }
+
+    QString path = m_req.path();
+    if (path.isEmpty()) {
+        path = ConfigHandler().savePath();
+    }
+    if (path.isEmpty()) {
+        AbstractLogger::error() << tr("No path to save the captures to");
+        return false;
+    }
+    // The frames are numbered after the name of the first one
+    const QFileInfo first(FileNameHandler().properScreenshotPath(
+      path, ConfigHandler().saveAsFileExtension()));
+    m_sequence.base = first.dir().filePath(first.completeBaseName());
+    m_sequence.suffix = first.suffix();
+    const QString suffix = m_sequence.suffix.toLower();
+    if (suffix == QLatin1String("jpg") || suffix == QLatin1String("jpeg")) {
+        m_sequence.quality = ConfigHandler().jpegQuality();
+    }
+    m_sequence.preset = Codecs::preset(ConfigHandler().encodingPreset());
+    m_sequence.pngLevel = ConfigHandler().pngCompressionLevel();
+
+    QTimer::singleShot(m_req.delay(), this, [this]() {
+        capture();
+        m_timer.start();
+    });
+    return true;
+}
+
+void IntervalCapture::capture()
+{
+    if (m_count > 0 && m_taken >= m_count) {
+        return;
+    }
+    ++m_taken;
+    if (m_grabbing || m_pending.loadAcquire() >= MAX_PENDING_FRAMES) {
+        // Grabbing or saving falls behind, keep the cadence rather than the
+        // frame
+        ++m_dropped;
+    } else {
+        m_grabbing = true;
+        const auto grabbed = [this](bool ok, const QPixmap& frame) {
+            m_grabbing = false;
+            if (ok) {
+                m_pending.ref();
+                m_pool.start(new FrameTask(this, frame.toImage()));
+            } else {
+                ++m_dropped;
+            }
+        };
+        if (m_screen != nullptr) {
+            m_grabber.grabScreenAsync(m_screen, m_region, this, grabbed);
+        } else {
+            m_grabber.grabEntireDesktopAsync(m_region, this, grabbed);
+        }
+    }
+    if (m_count > 0 && m_taken >= m_count) {
+        m_timer.stop();
+        finish();
+    }
+}
+
+void IntervalCapture::saveFrame(const QImage& image)
+{
+    Sequence& sequence = m_sequence;
+    const QString path = QStringLiteral("%1_%2.%3")
+                           .arg(sequence.base)
+                           .arg(sequence.index + 1, 6, 10, QLatin1Char('0'))
+                           .arg(sequence.suffix);
+    const bool unchanged = !sequence.lastPath.isEmpty() &&
+                           samePixels(image, sequence.lastImage);
+
+    bool ok = false;
+    if (unchanged) {
+        ok = linkFile(sequence.lastPath, path);
+        sequence.linked += ok ? 1 : 0;
+    } else {
+        const QByteArray data = Codecs::encode(image,
+                                               sequence.suffix.toLatin1(),
+                                               sequence.quality,
+                                               sequence.preset,
+                                               sequence.pngLevel);
+        QFile file(path);
+        ok = !data.isEmpty() && file.open(QIODevice::WriteOnly) &&
+             file.write(data) == data.size();
+    }
+    if (!ok) {
+        ++sequence.failed;
+        AbstractLogger::error(AbstractLogger::Stderr)
+          << tr("Error trying to save as ") + path;
+        return;
+    }
+    ++sequence.index;
+    sequence.lastImage = image;
+    sequence.lastPath = path;
+}
+
+void IntervalCapture::finish()
+{
+    // Wait for the last frames without blocking the event loop
+    if (m_grabbing || m_pending.loadAcquire() > 0) {
+        QTimer::singleShot(m_timer.interval(), this, [this]() { finish(); });
+        return;
+    }
+    m_pool.waitForDone();
+    AbstractLogger::info(AbstractLogger::Stderr)
+      << tr("%1 frames saved to %2_*, %3 unchanged, %4 dropped")
+           .arg(m_sequence.index)
+           .arg(m_sequence.base)
+           .arg(m_sequence.linked)
+           .arg(m_dropped + m_sequence.failed);
+    emit finished(m_sequence.failed == 0);
+}
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include "src/core/capturerequest.h"
+#include "src/utils/codecs.h"
+#include "src/utils/screengrabber.h"
+#include <QAtomicInt>
+#include <QImage>
+#include <QObject>
+#include <QRect>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+class QScreen;
+
+/**
+ * @brief Captures the desktop or a screen at a fixed interval and saves every
+ * frame, for `flameshot full|screen --interval`.
+ *
+ * The process stays resident between the frames. The main thread only grabs
+ * the screen; comparing the frame with the previous one, encoding it and
+ * writing it happen in a background thread, so a slow encode doesn't delay
+ * the next frame. A frame whose pixels are all the same as the ones of the
+ * previous frame is not encoded again: its file is a hard link to the
+ * previous one (a copy where hard links are not supported).
+ *
+ * Frames are numbered after the file name given by the path and the filename
+ * pattern, e.g. `2023-01-01_10-00_000001.png`.
+ */
+class IntervalCapture : public QObject
+{
+    Q_OBJECT
+public:
+    // `count` frames are taken, or until the process is stopped when 0
+    IntervalCapture(const CaptureRequest& req,
+                    int interval,
+                    int count,
+                    QObject* parent = nullptr);
+    ~IntervalCapture();
+
+    // Returns false if the capture can't start, after logging why
+    bool start();
+
+signals:
+    // Emitted once the last frame is written
+    void finished(bool ok);
+
+private:
+    // State of the saved sequence, only used by the thread of `m_pool`
+    struct Sequence
+    {
+        QString base;
+        QString suffix;
+        int quality = -1;
+        Codecs::Preset preset = Codecs::Balanced;
+        int pngLevel = 6;
+        int index = 0;
+        QImage lastImage;
+        QString lastPath;
+        int linked = 0;
+        int failed = 0;
+    };
+
+    class FrameTask;
+
+    void capture();
+    void saveFrame(const QImage& image);
+    void finish();
+
+    // class members
+    CaptureRequest m_req;
+    int m_count;
+    int m_taken;
+    int m_dropped;
+    QScreen* m_screen;
+    QRect m_region;
+    // A portal capture is waited for in the event loop
+    bool m_grabbing;
+    ScreenGrabber m_grabber;
+    QTimer m_timer;
+    // A single thread, the frames are saved in order
+    QThreadPool m_pool;
+    QAtomicInt m_pending;
+    Sequence m_sequence;
+};
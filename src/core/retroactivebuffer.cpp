@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "retroactivebuffer.h"
+#include "confighandler.h"
+#include "src/utils/desktopinfo.h"
+#include "src/utils/screengrabber.h"
+#include <QDateTime>
+#include <QHash>
+#include <QRunnable>
+#include <algorithm>
+#include <cstring>
+
+// Side of the square tiles, in pixels
+#define TILE_SIZE 128
+// zlib level, the tiles are compressed at every frame so speed matters more
+#define COMPRESSION_LEVEL 1
+
+namespace {
+
+bool sameTile(const QImage& a, const QImage& b, const QRect& rect)
+{
+    const int offset = rect.x() * 4;
+    const size_t length = rect.width() * 4;
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        if (std::memcmp(a.constScanLine(y) + offset,
+                        b.constScanLine(y) + offset,
+                        length) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QByteArray tileBytes(const QImage& image, const QRect& rect)
+{
+    const int offset = rect.x() * 4;
+    const int length = rect.width() * 4;
+    QByteArray bytes;
+    bytes.reserve(length * rect.height());
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        bytes.append(
+          reinterpret_cast<const char*>(image.constScanLine(y)) + offset,
+          length);
+    }
+    return bytes;
+}
+
+QVector<QRect> tileRects(const QSize& size)
+{
+    QVector<QRect> rects;
+    for (int y = 0; y < size.height(); y += TILE_SIZE) {
+        for (int x = 0; x < size.width(); x += TILE_SIZE) {
+            rects.append(QRect(x,
+                               y,
+                               qMin(TILE_SIZE, size.width() - x),
+                               qMin(TILE_SIZE, size.height() - y)));
+        }
+    }
+    return rects;
+}
+
+} // namespace
+
+class RetroactiveBuffer::CompressTask : public QRunnable
+{
+public:
+    CompressTask(RetroactiveBuffer* buffer,
+                 const QImage& image,
+                 const QImage& previous,
+                 const Frame& frame,
+                 const QVector<Tile>& previousTiles)
+      : m_buffer(buffer)
+      , m_image(image)
+      , m_previous(previous)
+      , m_frame(frame)
+      , m_previousTiles(previousTiles)
+    {}
+
+    void run() override
+    {
+        const QImage image = m_image.convertToFormat(QImage::Format_RGB32);
+        const QVector<QRect> rects = tileRects(image.size());
+        // Tiles are only shared with a frame of the same size
+        const bool comparable = m_previous.size() == image.size() &&
+                                m_previousTiles.size() == rects.size();
+        m_frame.tiles.reserve(rects.size());
+        for (int i = 0; i < rects.size(); ++i) {
+            if (comparable && sameTile(image, m_previous, rects.at(i))) {
+                m_frame.tiles.append(m_previousTiles.at(i));
+            } else {
+                m_frame.tiles.append(Tile(new QByteArray(qCompress(
+                  tileBytes(image, rects.at(i)), COMPRESSION_LEVEL))));
+            }
+        }
+        RetroactiveBuffer* buffer = m_buffer;
+        const Frame frame = m_frame;
+        QMetaObject::invokeMethod(
+          buffer,
+          [buffer, frame, image]() { buffer->append(frame, image); },
+          Qt::QueuedConnection);
+    }
+
+private:
+    RetroactiveBuffer* m_buffer;
+    QImage m_image;
+    QImage m_previous;
+    Frame m_frame;
+    QVector<Tile> m_previousTiles;
+};
+
+RetroactiveBuffer::RetroactiveBuffer(QObject* parent)
+  : QObject(parent)
+  , m_busy(false)
+  , m_duration(0)
+  , m_memoryLimit(0)
+  , m_memoryUsage(0)
+{
+    m_pool.setMaxThreadCount(1);
+    reloadConfig();
+    connect(&m_timer, &QTimer::timeout, this, &RetroactiveBuffer::grab);
+    m_timer.start();
+}
+
+RetroactiveBuffer::~RetroactiveBuffer()
+{
+    m_timer.stop();
+    // The task of a pending frame refers to this object
+    m_pool.waitForDone();
+}
+
+bool RetroactiveBuffer::isSupported()
+{
+#if (defined(Q_OS_LINUX) || defined(Q_OS_UNIX)) && !defined(Q_OS_MACOS)
+    return !DesktopInfo().waylandDetected();
+#else
+    return false;
+#endif
+}
+
+void RetroactiveBuffer::setPaused(bool paused)
+{
+    if (paused) {
+        m_timer.stop();
+    } else if (!m_timer.isActive()) {
+        m_timer.start();
+    }
+}
+
+void RetroactiveBuffer::reloadConfig()
+{
+    ConfigHandler config;
+    m_timer.setInterval(config.retroactiveCaptureInterval());
+    m_duration = config.retroactiveCaptureDuration() * 1000;
+    m_memoryLimit = config.retroactiveCaptureMemoryLimit() * 1024LL * 1024LL;
+    if (!m_frames.isEmpty()) {
+        evict();
+    }
+}
+
+QPixmap RetroactiveBuffer::frame(int secondsAgo) const
+{
+    if (m_frames.isEmpty()) {
+        return QPixmap();
+    }
+    const qint64 target =
+      QDateTime::currentMSecsSinceEpoch() - secondsAgo * 1000LL;
+    auto found = std::find_if(
+      m_frames.rbegin(), m_frames.rend(), [target](const Frame& frame) {
+          return frame.timestamp <= target;
+      });
+    const Frame& frame = found != m_frames.rend() ? *found : m_frames.first();
+
+    QImage image(frame.size, QImage::Format_RGB32);
+    const QVector<QRect> rects = tileRects(frame.size);
+    for (int i = 0; i < rects.size(); ++i) {
+        const QRect& rect = rects.at(i);
+        const QByteArray bytes = qUncompress(*frame.tiles.at(i));
+        const int length = rect.width() * 4;
+        if (bytes.size() != length * rect.height()) {
+            continue;
+        }
+        for (int y = 0; y < rect.height(); ++y) {
+            std::memcpy(image.scanLine(rect.y() + y) + rect.x() * 4,
+                        bytes.constData() + y * length,
+                        length);
+        }
+    }
+    QPixmap pixmap = QPixmap::fromImage(image);
+    pixmap.setDevicePixelRatio(frame.devicePixelRatio);
+    return pixmap;
+}
+
+qint64 RetroactiveBuffer::memoryUsage() const
+{
+    return m_memoryUsage;
+}
+
+void RetroactiveBuffer::grab()
+{
+    // Skip the frame while the previous one is still being compressed
+    if (m_busy) {
+        return;
+    }
+    bool ok = true;
+    const QPixmap capture = ScreenGrabber().grabEntireDesktop(ok);
+    if (!ok || capture.isNull()) {
+        return;
+    }
+    m_busy = true;
+    const Frame frame{ QDateTime::currentMSecsSinceEpoch(),
+                       capture.size(),
+                       capture.devicePixelRatio(),
+                       {} };
+    m_pool.start(new CompressTask(
+      this,
+      capture.toImage(),
+      m_lastImage,
+      frame,
+      m_frames.isEmpty() ? QVector<Tile>() : m_frames.last().tiles));
+}
+
+void RetroactiveBuffer::append(const Frame& frame, const QImage& image)
+{
+    m_busy = false;
+    m_lastImage = image;
+    m_frames.append(frame);
+    evict();
+}
+
+void RetroactiveBuffer::evict()
+{
+    // Shared tiles are only counted once
+    QHash<const QByteArray*, int> users;
+    m_memoryUsage = 0;
+    for (const Frame& frame : qAsConst(m_frames)) {
+        for (const Tile& tile : frame.tiles) {
+            if (users[tile.data()]++ == 0) {
+                m_memoryUsage += tile->size();
+            }
+        }
+    }
+
+    // The last frame is always kept
+    const qint64 oldest = m_frames.last().timestamp - m_duration;
+    int dropped = 0;
+    while (dropped < m_frames.size() - 1) {
+        const Frame& frame = m_frames.at(dropped);
+        if (frame.timestamp >= oldest && m_memoryUsage <= m_memoryLimit) {
+            break;
+        }
+        for (const Tile& tile : frame.tiles) {
+            if (--users[tile.data()] == 0) {
+                m_memoryUsage -= tile->size();
+            }
+        }
+        ++dropped;
+    }
+    m_frames.remove(0, dropped);
+}
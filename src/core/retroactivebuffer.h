@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QByteArray>
+#include <QImage>
+#include <QObject>
+#include <QPixmap>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+/**
+ * @brief Recent captures of the desktop, kept by the daemon so the editor can
+ * be opened on what the screen showed a few seconds ago.
+ *
+ * The desktop is grabbed at a low rate (`retroactiveCaptureInterval`). Every
+ * frame is cut into tiles which are compressed in a background thread; a tile
+ * that didn't change since the previous frame is shared with it instead of
+ * being stored again, so a mostly static desktop costs little more than one
+ * compressed frame. The oldest frames are dropped once they are older than
+ * `retroactiveCaptureDuration` or the tiles use more than
+ * `retroactiveCaptureMemoryLimit`.
+ *
+ * Grabbing runs in the GUI thread, so it is only done on X11 where it is a
+ * shared memory copy (see `isSupported`).
+ */
+class RetroactiveBuffer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RetroactiveBuffer(QObject* parent = nullptr);
+    ~RetroactiveBuffer();
+
+    // Whether the desktop can be grabbed cheaply enough: only on X11, where
+    // it doesn't go through a portal asking for the permission
+    static bool isSupported();
+
+    // Read the rate and the limits from the configuration again
+    void reloadConfig();
+    // Stop grabbing, e.g. while the capture editor covers the desktop
+    void setPaused(bool paused);
+    // The last frame grabbed at least `secondsAgo` seconds ago (the oldest
+    // one when there is none), a null pixmap when nothing was recorded yet
+    QPixmap frame(int secondsAgo) const;
+    // Memory used by the compressed tiles, in bytes
+    qint64 memoryUsage() const;
+
+private:
+    using Tile = QSharedPointer<const QByteArray>;
+
+    struct Frame
+    {
+        qint64 timestamp;
+        QSize size;
+        qreal devicePixelRatio;
+        QVector<Tile> tiles;
+    };
+
+    class CompressTask;
+
+    void grab();
+    void append(const Frame& frame, const QImage& image);
+    void evict();
+
+    // class members
+    QTimer m_timer;
+    // A single thread, frames are compressed one after the other
+    QThreadPool m_pool;
+    bool m_busy;
+    qint64 m_duration;
+    qint64 m_memoryLimit;
+    qint64 m_memoryUsage;
+    QVector<Frame> m_frames;
+    // Pixels of the last frame, compared with the next one
+    QImage m_lastImage;
+};
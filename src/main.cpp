@@ -14,9 +14,13 @@
 #include "src/core/capturerequest.h"
 #include "src/core/flameshot.h"
 #include "src/core/flameshotdaemon.h"
+#include "src/core/intervalcapture.h"
 #include "src/utils/confighandler.h"
 #include "src/utils/filenamehandler.h"
 #include "src/utils/valuehandler.h"
+#ifdef FLAMESHOT_BENCHMARK
+#include "src/core/capturebenchmark.h"
+#endif
 #include <QApplication>
 #include <QDir>
 #include <QLibraryInfo>
@@ -72,6 +76,18 @@ void requestCaptureAndWait(const CaptureRequest& req)
     qApp->exec();
 }
 
+int runIntervalCapture(const CaptureRequest& req, int interval, int count)
+{
+    IntervalCapture capture(req, interval, count);
+    if (!capture.start()) {
+        return 1;
+    }
+    QObject::connect(&capture, &IntervalCapture::finished, [](bool ok) {
+        qApp->exit(ok ? 0 : 1);
+    });
+    return qApp->exec();
+}
+
 QSharedMemory* guiMutexLock()
 {
     QString key = "org.flameshot.Flameshot-" APP_VERSION;
@@ -157,6 +173,16 @@ int main(int argc, char* argv[])
     QCoreApplication::setApplicationName(QStringLiteral("flameshot"));
     QCoreApplication::setOrganizationName(QStringLiteral("flameshot"));
 
+#ifdef FLAMESHOT_BENCHMARK
+    // flameshot benchmark [iterations], see CaptureBenchmark
+    if (argc >= 2 && qstrcmp(argv[1], "benchmark") == 0) {
+        QApplication app(argc, argv);
+        configureApp(true);
+        return CaptureBenchmark(argc >= 3 ? QByteArray(argv[2]).toInt() : 0)
+          .run();
+    }
+#endif
+
     // no arguments, just launch Flameshot
     if (argc == 1) {
 #ifndef USE_EXTERNAL_SINGLEAPPLICATION
@@ -272,6 +298,20 @@ int main(int argc, char* argv[])
       QObject::tr("Screen number"),
       QStringLiteral("-1"));
 
+    CommandOption intervalOption(
+      "interval",
+      QObject::tr("Keep capturing at this interval, saving every frame"),
+      QStringLiteral("milliseconds"));
+    CommandOption countOption(
+      "count",
+      QObject::tr("Number of frames taken with --interval, 0 for no limit"),
+      QStringLiteral("frames"));
+    CommandOption agoOption(
+      "ago",
+      QObject::tr("Edit the screen as it was this many seconds ago, requires "
+                  "retroactiveCapture in the configuration"),
+      QStringLiteral("seconds"));
+
     CommandOption fileHack({ "_", "filehack" },
                            QObject::tr("Provide the file with no arguments."),
                            QStringLiteral("file-hack"));
@@ -294,6 +334,12 @@ int main(int argc, char* argv[])
       QObject::tr("Invalid delay, it must be a number greater than 0");
     const QString numberErr =
       QObject::tr("Invalid screen number, it must be non negative");
+    const QString intervalErr =
+      QObject::tr("Invalid interval, it must be a number greater than 0");
+    const QString countErr =
+      QObject::tr("Invalid count, it must be a non negative number");
+    const QString agoErr =
+      QObject::tr("Invalid time, it must be a number of seconds");
     const QString regionErr = QObject::tr(
       "Invalid region, use 'WxH+X+Y' or 'all' or 'screen0/screen1/...'.");
     auto numericChecker = [](const QString& delayValue) -> bool {
@@ -336,6 +382,11 @@ int main(int argc, char* argv[])
     autostartOption.addChecker(booleanChecker, booleanErr);
     showHelpOption.addChecker(booleanChecker, booleanErr);
     screenNumberOption.addChecker(numericChecker, numberErr);
+    agoOption.addChecker(numericChecker, agoErr);
+    intervalOption.addChecker(
+      [](const QString& value) -> bool { return value.toInt() > 0; },
+      intervalErr);
+    countOption.addChecker(numericChecker, countErr);
 
     // Relationships
     parser.AddArgument(guiArgument);
@@ -355,7 +406,8 @@ int main(int argc, char* argv[])
                         selectionOption,
                         uploadOption,
                         pinOption,
-                        acceptOnSelectOption },
+                        acceptOnSelectOption,
+                        agoOption },
                       guiArgument);
     parser.AddOptions({ screenNumberOption,
                         clipboardOption,
@@ -364,14 +416,18 @@ int main(int argc, char* argv[])
                         regionOption,
                         rawImageOption,
                         uploadOption,
-                        pinOption },
+                        pinOption,
+                        intervalOption,
+                        countOption },
                       screenArgument);
     parser.AddOptions({ pathOption,
                         clipboardOption,
                         delayOption,
                         regionOption,
                         rawImageOption,
-                        uploadOption },
+                        uploadOption,
+                        intervalOption,
+                        countOption },
                       fullArgument);
     parser.AddOptions({ autostartOption,
                         filenameOption,
@@ -399,6 +455,14 @@ int main(int argc, char* argv[])
         qApp->exec();
     } else if (parser.isSet(guiArgument)) { // GUI
         reinitializeAsQApplication(argc, argv);
+        // The daemon keeps the recent captures, it opens the editor itself
+        if (parser.isSet(agoOption)) {
+            if (!FlameshotDaemon::openRetroactiveCapture(
+                  parser.value(agoOption).toInt())) {
+                return 1;
+            }
+            goto finish;
+        }
         // Prevent multiple instances of 'flameshot gui' from running if not
         // configured to do so.
         if (!ConfigHandler().allowMultipleGuiInstances()) {
@@ -494,6 +558,21 @@ int main(int argc, char* argv[])
         if (!clipboard && path.isEmpty() && !raw && !upload) {
             req.addSaveTask();
         }
+        if (parser.isSet(countOption) && !parser.isSet(intervalOption)) {
+            AbstractLogger::error()
+              << QObject::tr("--count is only used with --interval");
+            return 1;
+        }
+        if (parser.isSet(intervalOption)) {
+            if (clipboard || raw || upload) {
+                AbstractLogger::error()
+                  << QObject::tr("--interval only saves the captures");
+                return 1;
+            }
+            return runIntervalCapture(req,
+                                      parser.value(intervalOption).toInt(),
+                                      parser.value(countOption).toInt());
+        }
         requestCaptureAndWait(req);
     } else if (parser.isSet(screenArgument)) { // SCREEN
         reinitializeAsQApplication(argc, argv);
@@ -543,6 +622,21 @@ int main(int argc, char* argv[])
         if (!clipboard && !raw && path.isEmpty() && !pin && !upload) {
             req.addSaveTask();
         }
+        if (parser.isSet(countOption) && !parser.isSet(intervalOption)) {
+            AbstractLogger::error()
+              << QObject::tr("--count is only used with --interval");
+            return 1;
+        }
+        if (parser.isSet(intervalOption)) {
+            if (clipboard || raw || pin || upload) {
+                AbstractLogger::error()
+                  << QObject::tr("--interval only saves the captures");
+                return 1;
+            }
+            return runIntervalCapture(req,
+                                      parser.value(intervalOption).toInt(),
+                                      parser.value(countOption).toInt());
+        }
 
         requestCaptureAndWait(req);
     } else if (parser.isSet(configArgument)) { // CONFIG
@@ -27,7 +27,7 @@ QRect AbstractActionTool::boundingRect() const
     return {};
 }
 
-void AbstractActionTool::process(QPainter& painter, const QPixmap& pixmap)
+void AbstractActionTool::process(QPainter& painter, const TiledPixmap& pixmap)
 {
     Q_UNUSED(painter)
     Q_UNUSED(pixmap)
@@ -2,8 +2,13 @@
 // SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
 
 #include "abstractpathtool.h"
+#include <QLineF>
+#include <QPair>
 #include <cmath>
 
+// Maximum distance in pixels between a committed path and the drawn one
+#define PATH_SIMPLIFY_TOLERANCE 1.0
+
 AbstractPathTool::AbstractPathTool(QObject* parent)
   : CaptureTool(parent)
   , m_thickness(1)
@@ -17,11 +22,8 @@ void AbstractPathTool::copyParams(const AbstractPathTool* from,
     to->m_thickness = from->m_thickness;
     to->m_padding = from->m_padding;
     to->m_pos = from->m_pos;
-
-    to->m_points.clear();
-    for (auto point : from->m_points) {
-        to->m_points.append(point);
-    }
+    to->m_pathArea = from->m_pathArea;
+    to->m_points = from->m_points;
 }
 
 bool AbstractPathTool::isValid() const
@@ -56,37 +58,19 @@ QRect AbstractPathTool::boundingRect() const
     if (m_points.isEmpty()) {
         return {};
     }
-    int min_x = m_points.at(0).x();
-    int min_y = m_points.at(0).y();
-    int max_x = m_points.at(0).x();
-    int max_y = m_points.at(0).y();
-    for (auto point : m_points) {
-        if (point.x() < min_x) {
-            min_x = point.x();
-        }
-        if (point.y() < min_y) {
-            min_y = point.y();
-        }
-        if (point.x() > max_x) {
-            max_x = point.x();
-        }
-        if (point.y() > max_y) {
-            max_y = point.y();
-        }
-    }
-
     int offset =
       m_thickness <= 1 ? 1 : static_cast<int>(round(m_thickness * 0.7 + 0.5));
-    return QRect(min_x - offset,
-                 min_y - offset,
-                 std::abs(min_x - max_x) + offset * 2,
-                 std::abs(min_y - max_y) + offset * 2)
+    return QRect(m_pathArea.left() - offset,
+                 m_pathArea.top() - offset,
+                 m_pathArea.right() - m_pathArea.left() + offset * 2,
+                 m_pathArea.bottom() - m_pathArea.top() + offset * 2)
       .normalized();
 }
 
 void AbstractPathTool::drawEnd(const QPoint& p)
 {
     Q_UNUSED(p)
+    simplifyPath(PATH_SIMPLIFY_TOLERANCE);
 }
 
 void AbstractPathTool::drawMove(const QPoint& p)
@@ -106,7 +90,9 @@ void AbstractPathTool::onSizeChanged(int size)
 
 void AbstractPathTool::addPoint(const QPoint& point)
 {
-    if (m_pathArea.left() > point.x()) {
+    if (m_points.isEmpty()) {
+        m_pathArea = QRect(point, point);
+    } else if (m_pathArea.left() > point.x()) {
         m_pathArea.setLeft(point.x());
     } else if (m_pathArea.right() < point.x()) {
         m_pathArea.setRight(point.x());
@@ -129,25 +115,82 @@ void AbstractPathTool::move(const QPoint& mousePos)
     for (auto& m_point : m_points) {
         m_point += offset;
     }
+    m_pathArea.translate(offset);
+}
+
+qint64 AbstractPathTool::memoryUsage() const
+{
+    return sizeof(AbstractPathTool) + m_points.capacity() * sizeof(QPoint);
 }
 
 const QPoint* AbstractPathTool::pos()
 {
-    if (m_points.empty()) {
-        m_pos = QPoint();
-        return &m_pos;
+    m_pos = m_points.empty() ? QPoint() : m_pathArea.topLeft();
+    return &m_pos;
+}
+
+void AbstractPathTool::simplifyPath(qreal tolerance)
+{
+    const int count = m_points.size();
+    if (count < 3) {
+        return;
     }
-    int x = m_points.at(0).x();
-    int y = m_points.at(0).y();
-    for (auto point : m_points) {
-        if (point.x() < x) {
-            x = point.x();
+    QVector<bool> keep(count, false);
+    keep[0] = true;
+    keep[count - 1] = true;
+    // Iterative to support very long paths
+    QVector<QPair<int, int>> ranges{ { 0, count - 1 } };
+    while (!ranges.isEmpty()) {
+        const QPair<int, int> range = ranges.takeLast();
+        const QLineF chord(m_points.at(range.first), m_points.at(range.second));
+        const qreal length = chord.length();
+        qreal maxDistance = 0;
+        int farthest = -1;
+        for (int i = range.first + 1; i < range.second; ++i) {
+            const QPointF point = m_points.at(i);
+            qreal distance;
+            if (qFuzzyIsNull(length)) {
+                distance = QLineF(chord.p1(), point).length();
+            } else {
+                // Distance to the line through the chord
+                const QPointF d = chord.p2() - chord.p1();
+                const QPointF v = point - chord.p1();
+                distance = std::abs(d.x() * v.y() - d.y() * v.x()) / length;
+            }
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                farthest = i;
+            }
         }
-        if (point.y() < y) {
-            y = point.y();
+        if (farthest >= 0 && maxDistance > tolerance) {
+            keep[farthest] = true;
+            ranges.append({ range.first, farthest });
+            ranges.append({ farthest, range.second });
         }
     }
-    m_pos.setX(x);
-    m_pos.setY(y);
-    return &m_pos;
+
+    QVector<QPoint> points;
+    points.reserve(keep.count(true));
+    for (int i = 0; i < count; ++i) {
+        if (keep.at(i)) {
+            points.append(m_points.at(i));
+        }
+    }
+    m_points = points;
+    updatePathArea();
+}
+
+void AbstractPathTool::updatePathArea()
+{
+    if (m_points.isEmpty()) {
+        m_pathArea = QRect();
+        return;
+    }
+    m_pathArea = QRect(m_points.first(), m_points.first());
+    for (const QPoint& point : qAsConst(m_points)) {
+        m_pathArea.setLeft(qMin(m_pathArea.left(), point.x()));
+        m_pathArea.setTop(qMin(m_pathArea.top(), point.y()));
+        m_pathArea.setRight(qMax(m_pathArea.right(), point.x()));
+        m_pathArea.setBottom(qMax(m_pathArea.bottom(), point.y()));
+    }
 }
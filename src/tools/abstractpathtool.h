@@ -20,6 +20,7 @@ public:
     void move(const QPoint& mousePos) override;
     const QPoint* pos() override;
     int size() const override { return m_thickness; };
+    qint64 memoryUsage() const override;
 
 public slots:
     void drawEnd(const QPoint& p) override;
@@ -30,8 +31,13 @@ public slots:
 protected:
     void copyParams(const AbstractPathTool* from, AbstractPathTool* to);
     void addPoint(const QPoint& point);
+    // Remove the points closer than `tolerance` pixels to the simplified
+    // path (Ramer-Douglas-Peucker)
+    void simplifyPath(qreal tolerance);
+    void updatePathArea();
 
     // class members
+    // Bounds of m_points, kept up to date as the points are added
     QRect m_pathArea;
     QColor m_color;
     QVector<QPoint> m_points;
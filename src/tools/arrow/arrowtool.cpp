@@ -146,7 +146,7 @@ void ArrowTool::copyParams(const ArrowTool* from, ArrowTool* to)
     to->m_arrowPath = this->m_arrowPath;
 }
 
-void ArrowTool::process(QPainter& painter, const QPixmap& pixmap)
+void ArrowTool::process(QPainter& painter, const TiledPixmap& pixmap)
 {
     Q_UNUSED(pixmap)
     painter.setPen(QPen(color(), size()));
@@ -9,7 +9,7 @@
 QPixmap CaptureContext::selectedScreenshotArea() const
 {
     if (selection.isNull()) {
-        return screenshot;
+        return screenshot.copy();
     } else {
         return screenshot.copy(selection);
     }
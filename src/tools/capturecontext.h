@@ -4,6 +4,7 @@
 #pragma once
 
 #include "capturerequest.h"
+#include "src/utils/tiledpixmap.h"
 #include <QPainter>
 #include <QPixmap>
 #include <QPoint>
@@ -12,9 +13,9 @@
 struct CaptureContext
 {
     // screenshot with modifications
-    QPixmap screenshot;
-    // unmodified screenshot
-    QPixmap origScreenshot;
+    TiledPixmap screenshot;
+    // unmodified screenshot, shares the tiles that have not been modified
+    TiledPixmap origScreenshot;
     // Selection area
     QRect selection;
     // Selected tool color
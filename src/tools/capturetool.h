@@ -133,14 +133,22 @@ public:
     // return true if object was change after editMode
     virtual bool isChanged() { return true; };
 
+    // Return true if process() reads the pixels beneath the object (e.g.
+    // pixelation), so the object is always redrawn as a whole.
+    virtual bool readsBackground() const { return false; };
+
+    // Approximate memory used by the object, used to limit the size of the
+    // undo history.
+    virtual qint64 memoryUsage() const { return sizeof(CaptureTool); };
+
     // Counter for all object types (currently is used for the CircleCounter
     // only)
     virtual void setCount(int count) { m_count = count; };
     virtual int count() const { return m_count; };
 
     // Called every time the tool has to draw
-    virtual void process(QPainter& painter, const QPixmap& pixmap) = 0;
-    virtual void drawSearchArea(QPainter& painter, const QPixmap& pixmap)
+    virtual void process(QPainter& painter, const TiledPixmap& pixmap) = 0;
+    virtual void drawSearchArea(QPainter& painter, const TiledPixmap& pixmap)
     {
         process(painter, pixmap);
     };
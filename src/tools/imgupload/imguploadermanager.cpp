@@ -33,7 +33,7 @@ void ImgUploaderManager::init()
     m_imgUploaderPlugin = "privateuploader";
 }
 
-ImgUploaderBase* ImgUploaderManager::uploader(const QPixmap& capture,
+ImgUploaderBase* ImgUploaderManager::uploader(const EncodedCapture& capture,
                                               QWidget* parent)
 {
     // TODO - implement ImgUploader for other Storages and selection among them,
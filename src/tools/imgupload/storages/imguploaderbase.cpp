@@ -3,6 +3,7 @@
 
 #include "imguploaderbase.h"
 #include "src/core/flameshotdaemon.h"
+#include "src/utils/codecs.h"
 #include "src/utils/confighandler.h"
 #include "src/utils/globalvalues.h"
 #include "src/utils/history.h"
@@ -30,9 +31,10 @@
 #include <QUrlQuery>
 #include <QVBoxLayout>
 
-ImgUploaderBase::ImgUploaderBase(const QPixmap& capture, QWidget* parent)
+ImgUploaderBase::ImgUploaderBase(const EncodedCapture& capture,
+                                 QWidget* parent)
   : QWidget(parent)
-  , m_pixmap(capture)
+  , m_capture(capture)
 {
     FlameshotDaemon::copyToClipboard("");
     if (!ConfigHandler().uploadWindowEnabled()) {
@@ -144,12 +146,27 @@ void ImgUploaderBase::setImageURL(const QUrl& imageURL)
 
 const QPixmap& ImgUploaderBase::pixmap()
 {
-    return m_pixmap;
+    return m_capture.pixmap();
 }
 
 void ImgUploaderBase::setPixmap(const QPixmap& pixmap)
 {
-    m_pixmap = pixmap;
+    m_capture = EncodedCapture(pixmap);
+}
+
+const EncodedCapture& ImgUploaderBase::capture() const
+{
+    return m_capture;
+}
+
+QByteArray ImgUploaderBase::uploadFormat() const
+{
+    return Codecs::normalizedFormat(ConfigHandler().uploadFormat().toLatin1());
+}
+
+QByteArray ImgUploaderBase::uploadData() const
+{
+    return m_capture.encodedAs(uploadFormat(), ConfigHandler().jpegQuality());
 }
 
 void ImgUploaderBase::setInfoLabelText(const QString& text)
@@ -234,7 +251,7 @@ void ImgUploaderBase::showPostUploadDialog(int open) {
         auto* imageLabel = new ImageLabel();
 
         imageLabel->setScreenshot(
-          m_pixmap.scaled(ConfigHandler().uploadWindowImageWidth(),
+          pixmap().scaled(ConfigHandler().uploadWindowImageWidth(),
                           ConfigHandler().uploadWindowScaleHeight() - 20,
                           Qt::KeepAspectRatio,
                           Qt::SmoothTransformation));
@@ -310,7 +327,7 @@ void ImgUploaderBase::copyURL()
 
 void ImgUploaderBase::copyImage()
 {
-    FlameshotDaemon::copyToClipboard(m_pixmap);
+    FlameshotDaemon::copyToClipboard(m_capture);
 }
 
 void ImgUploaderBase::deleteCurrentImage()
@@ -322,7 +339,7 @@ void ImgUploaderBase::deleteCurrentImage()
 
 void ImgUploaderBase::saveScreenshotToFilesystem()
 {
-    if (!saveToFilesystemGUI(m_pixmap)) {
+    if (!saveToFilesystemGUI(m_capture)) {
         return;
     }
 }
\ No newline at end of file
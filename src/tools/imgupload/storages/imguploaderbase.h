@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "src/utils/encodedcapture.h"
 #include <QUrl>
 #include <QWidget>
 
@@ -21,7 +22,8 @@ class ImgUploaderBase : public QWidget
     Q_OBJECT
 
 public:
-    explicit ImgUploaderBase(const QPixmap& capture, QWidget* parent = nullptr);
+    explicit ImgUploaderBase(const EncodedCapture& capture,
+                             QWidget* parent = nullptr);
 
     LoadSpinner* spinner();
 
@@ -29,6 +31,12 @@ public:
     void setImageURL(const QUrl&);
     const QPixmap& pixmap();
     void setPixmap(const QPixmap&);
+    // The capture, its encodings are shared with the other exports
+    const EncodedCapture& capture() const;
+    // The format captures are uploaded in, from the config
+    QByteArray uploadFormat() const;
+    // The capture encoded in the upload format
+    QByteArray uploadData() const;
     void setInfoLabelText(const QString&);
 
     virtual void deleteImage(const QString& fileName,
@@ -55,7 +63,7 @@ private slots:
     void saveScreenshotToFilesystem();
 
 private:
-    QPixmap m_pixmap;
+    EncodedCapture m_capture;
 
     QVBoxLayout* m_vLayout;
     QHBoxLayout* m_hLayout;
@@ -7,7 +7,6 @@
 #include "src/utils/history.h"
 #include "src/widgets/loadspinner.h"
 #include "src/widgets/notificationwidget.h"
-#include <QBuffer>
 #include <QDesktopServices>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -17,7 +16,8 @@
 #include <QShortcut>
 #include <QUrlQuery>
 
-ImgurUploader::ImgurUploader(const QPixmap& capture, QWidget* parent)
+ImgurUploader::ImgurUploader(const EncodedCapture& capture,
+                              QWidget* parent)
   : ImgUploaderBase(capture, parent)
 {
     m_NetworkAM = new QNetworkAccessManager(this);
@@ -61,9 +61,7 @@ void ImgurUploader::handleReply(QNetworkReply* reply)
 
 void ImgurUploader::upload()
 {
-    QByteArray byteArray;
-    QBuffer buffer(&byteArray);
-    pixmap().save(&buffer, "PNG");
+    QByteArray byteArray = uploadData();
 
     QUrlQuery urlQuery;
     urlQuery.addQueryItem(QStringLiteral("title"), QStringLiteral(""));
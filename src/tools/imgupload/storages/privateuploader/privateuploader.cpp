@@ -3,12 +3,12 @@
 
 #include "privateuploader.h"
 #include "privateuploaderupload.h"
+#include "src/utils/codecs.h"
 #include "src/utils/confighandler.h"
 #include "src/utils/filenamehandler.h"
 #include "src/utils/history.h"
 #include "src/widgets/loadspinner.h"
 #include "src/widgets/notificationwidget.h"
-#include <QBuffer>
 #include <QDesktopServices>
 #include <QEventLoop>
 #include <QHttpMultiPart>
@@ -22,7 +22,8 @@
 #include <QUrlQuery>
 #include <iostream>
 
-PrivateUploader::PrivateUploader(const QPixmap& capture, QWidget* parent)
+PrivateUploader::PrivateUploader(const EncodedCapture& capture,
+                                  QWidget* parent)
   : ImgUploaderBase(capture, parent)
 {
     m_NetworkAM = new QNetworkAccessManager(this);
@@ -65,14 +66,12 @@ void PrivateUploader::handleReply(QNetworkReply* reply)
 
 void PrivateUploader::upload()
 {
-    QByteArray byteArray;
-    QBuffer buffer(&byteArray);
-    pixmap().save(&buffer, "PNG");
+    QByteArray byteArray = uploadData();
 
     PrivateUploaderUpload* uploader = new PrivateUploaderUpload(this);
     connect(uploader,
             &PrivateUploaderUpload::uploadOk,
-            [this, uploader, &buffer](QNetworkReply* reply) {
+            [this, uploader](QNetworkReply* reply) {
                 handleReply(reply);
                 uploader->deleteLater();
             });
@@ -80,12 +79,13 @@ void PrivateUploader::upload()
             &PrivateUploaderUpload::uploadError,
             this,
             &PrivateUploader::handleReply);
+    const QString suffix = QStringLiteral(".") + uploadFormat();
     const QString& fileName =
-      FileNameHandler().parsedPattern().toLower().endsWith(".png")
+      FileNameHandler().parsedPattern().toLower().endsWith(suffix)
         ? FileNameHandler().parsedPattern()
-        : FileNameHandler().parsedPattern() + ".png";
-    uploader->uploadBytes(byteArray, fileName, "image/png");
-    buffer.close();
+        : FileNameHandler().parsedPattern() + suffix;
+    uploader->uploadBytes(
+      byteArray, fileName, Codecs::mimeType(uploadFormat()));
     byteArray.clear();
 
     connect(uploader,
@@ -15,7 +15,8 @@ class PrivateUploader : public ImgUploaderBase
 {
     Q_OBJECT
 public:
-    explicit PrivateUploader(const QPixmap& capture, QWidget* parent = nullptr);
+    explicit PrivateUploader(const EncodedCapture& capture,
+                             QWidget* parent = nullptr);
     void deleteImage(const QString& fileName, const QString& deleteToken);
     void uploadBytes(const QByteArray& bytes);
 
@@ -3,10 +3,8 @@
 
 #include "inverttool.h"
 #include <QApplication>
-#include <QGraphicsBlurEffect>
-#include <QGraphicsPixmapItem>
-#include <QGraphicsScene>
 #include <QImage>
+#include <QPaintEngine>
 #include <QPainter>
 #include <QPixmap>
 
@@ -47,9 +45,21 @@ CaptureTool* InvertTool::copy(QObject* parent)
     return tool;
 }
 
-void InvertTool::process(QPainter& painter, const QPixmap& pixmap)
+void InvertTool::process(QPainter& painter, const TiledPixmap& pixmap)
 {
     QRect selection = boundingRect().intersected(pixmap.rect());
+    if (painter.paintEngine()->hasFeature(QPaintEngine::BlendModes)) {
+        // Invert the pixels already painted, in place: the difference with
+        // opaque white is 1 - destination. The raster engine blends whole
+        // scanlines, and only the part inside the clip (tile) is touched.
+        painter.save();
+        painter.setRenderHint(QPainter::Antialiasing, false);
+        painter.setCompositionMode(QPainter::CompositionMode_Difference);
+        painter.fillRect(selection, Qt::white);
+        painter.restore();
+        return;
+    }
+
     auto pixelRatio = pixmap.devicePixelRatio();
     QRect selectionScaled = QRect(selection.topLeft() * pixelRatio,
                                   selection.bottomRight() * pixelRatio);
@@ -62,7 +72,7 @@ void InvertTool::process(QPainter& painter, const QPixmap& pixmap)
     painter.drawImage(selection, img);
 }
 
-void InvertTool::drawSearchArea(QPainter& painter, const QPixmap& pixmap)
+void InvertTool::drawSearchArea(QPainter& painter, const TiledPixmap& pixmap)
 {
     Q_UNUSED(pixmap)
     painter.fillRect(boundingRect(), QBrush(Qt::black));
@@ -17,8 +17,8 @@ public:
     QRect boundingRect() const override;
 
     CaptureTool* copy(QObject* parent = nullptr) override;
-    void process(QPainter& painter, const QPixmap& pixmap) override;
-    void drawSearchArea(QPainter& painter, const QPixmap& pixmap) override;
+    void process(QPainter& painter, const TiledPixmap& pixmap) override;
+    void drawSearchArea(QPainter& painter, const TiledPixmap& pixmap) override;
     void paintMousePreview(QPainter& painter,
                            const CaptureContext& context) override;
 
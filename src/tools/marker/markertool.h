@@ -17,7 +17,7 @@ public:
     QRect mousePreviewRect(const CaptureContext& context) const override;
 
     CaptureTool* copy(QObject* parent = nullptr) override;
-    void process(QPainter& painter, const QPixmap& pixmap) override;
+    void process(QPainter& painter, const TiledPixmap& pixmap) override;
     void paintMousePreview(QPainter& painter,
                            const CaptureContext& context) override;
 
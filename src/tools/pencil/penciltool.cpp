@@ -4,8 +4,14 @@
 #include "penciltool.h"
 #include <QPainter>
 
+// Margin added around the stroke cache when it grows, in logical pixels, so
+// it isn't reallocated for every new point
+#define STROKE_CACHE_MARGIN 128
+
 PencilTool::PencilTool(QObject* parent)
   : AbstractPathTool(parent)
+  , m_cachedPoints(0)
+  , m_drawing(false)
 {}
 
 QIcon PencilTool::icon(const QColor& background, bool inEditor) const
@@ -35,10 +41,18 @@ CaptureTool* PencilTool::copy(QObject* parent)
     return tool;
 }
 
-void PencilTool::process(QPainter& painter, const QPixmap& pixmap)
+void PencilTool::process(QPainter& painter, const TiledPixmap& pixmap)
 {
-    Q_UNUSED(pixmap)
-    painter.setPen(QPen(m_color, size()));
+    if (m_drawing) {
+        // Only the points added since the last call are rasterized
+        updateStrokeCache(pixmap.devicePixelRatio());
+        painter.save();
+        painter.setOpacity(m_color.alphaF());
+        painter.drawImage(m_strokeCacheRect.topLeft(), m_strokeCache);
+        painter.restore();
+        return;
+    }
+    painter.setPen(pen(m_color));
     painter.drawPolyline(m_points.data(), m_points.size());
 }
 
@@ -49,16 +63,86 @@ void PencilTool::paintMousePreview(QPainter& painter,
     painter.drawLine(context.mousePos, context.mousePos);
 }
 
+void PencilTool::drawEnd(const QPoint& p)
+{
+    m_drawing = false;
+    m_strokeCache = QImage();
+    m_strokeCacheRect = QRect();
+    m_cachedPoints = 0;
+    AbstractPathTool::drawEnd(p);
+}
+
+void PencilTool::drawMove(const QPoint& p)
+{
+    // Repeated events at the same position would only grow the path
+    if (m_points.isEmpty() || m_points.last() != p) {
+        addPoint(p);
+    }
+}
+
 void PencilTool::drawStart(const CaptureContext& context)
 {
     m_color = context.color;
     onSizeChanged(context.toolSize);
-    m_points.append(context.mousePos);
-    m_pathArea.setTopLeft(context.mousePos);
-    m_pathArea.setBottomRight(context.mousePos);
+    addPoint(context.mousePos);
+    m_drawing = true;
 }
 
 void PencilTool::pressed(CaptureContext& context)
 {
     Q_UNUSED(context)
 }
+
+QPen PencilTool::pen(const QColor& color) const
+{
+    // Round joins and caps, so the stroke looks the same when it is
+    // rasterized piece by piece
+    return QPen(color, size(), Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin);
+}
+
+void PencilTool::updateStrokeCache(qreal devicePixelRatio)
+{
+    const QRect area = boundingRect();
+    if (m_strokeCache.isNull() ||
+        m_strokeCache.devicePixelRatio() != devicePixelRatio ||
+        !m_strokeCacheRect.contains(area)) {
+        const QRect rect = area.united(m_strokeCacheRect) +
+                           QMargins(STROKE_CACHE_MARGIN,
+                                    STROKE_CACHE_MARGIN,
+                                    STROKE_CACHE_MARGIN,
+                                    STROKE_CACHE_MARGIN);
+        QImage cache(rect.size() * devicePixelRatio,
+                     QImage::Format_ARGB32_Premultiplied);
+        cache.setDevicePixelRatio(devicePixelRatio);
+        cache.fill(Qt::transparent);
+        if (!m_strokeCache.isNull() &&
+            m_strokeCache.devicePixelRatio() == devicePixelRatio) {
+            QPainter painter(&cache);
+            painter.setCompositionMode(QPainter::CompositionMode_Source);
+            painter.drawImage(m_strokeCacheRect.topLeft() - rect.topLeft(),
+                              m_strokeCache);
+        } else {
+            m_cachedPoints = 0;
+        }
+        m_strokeCache = cache;
+        m_strokeCacheRect = rect;
+    }
+    if (m_cachedPoints == m_points.size()) {
+        return;
+    }
+
+    QColor opaque(m_color);
+    opaque.setAlpha(255);
+    QPainter painter(&m_strokeCache);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.translate(-m_strokeCacheRect.topLeft());
+    painter.setPen(pen(opaque));
+    // The last rasterized point starts the new part of the polyline
+    const int first = qMax(0, m_cachedPoints - 1);
+    if (m_points.size() - first == 1) {
+        painter.drawPoint(m_points.at(first));
+    } else {
+        painter.drawPolyline(m_points.data() + first, m_points.size() - first);
+    }
+    m_cachedPoints = m_points.size();
+}
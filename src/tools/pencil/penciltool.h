@@ -4,6 +4,7 @@
 #pragma once
 
 #include "src/tools/abstractpathtool.h"
+#include <QImage>
 
 class PencilTool : public AbstractPathTool
 {
@@ -17,7 +18,7 @@ public:
 
     CaptureTool* copy(QObject* parent = nullptr) override;
 
-    void process(QPainter& painter, const QPixmap& pixmap) override;
+    void process(QPainter& painter, const TiledPixmap& pixmap) override;
     void paintMousePreview(QPainter& painter,
                            const CaptureContext& context) override;
 
@@ -25,6 +26,19 @@ protected:
     CaptureTool::Type type() const override;
 
 public slots:
+    void drawEnd(const QPoint& p) override;
+    void drawMove(const QPoint& p) override;
     void drawStart(const CaptureContext& context) override;
     void pressed(CaptureContext& context) override;
+
+private:
+    QPen pen(const QColor& color) const;
+    void updateStrokeCache(qreal devicePixelRatio);
+
+    // While the stroke is drawn, the points are rasterized once into this
+    // image, in an opaque color so overlapping segments don't add up
+    QImage m_strokeCache;
+    QRect m_strokeCacheRect;
+    int m_cachedPoints;
+    bool m_drawing;
 };
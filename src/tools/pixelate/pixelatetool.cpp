@@ -2,15 +2,18 @@
 // SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
 
 #include "pixelatetool.h"
+#include "src/utils/imagefilters.h"
 #include <QApplication>
-#include <QGraphicsBlurEffect>
-#include <QGraphicsPixmapItem>
-#include <QGraphicsScene>
 #include <QImage>
 #include <QPainter>
 
+// Standard deviation of the blur used when the thickness is less than 1, in
+// logical pixels
+#define BLUR_SIGMA 6
+
 PixelateTool::PixelateTool(QObject* parent)
   : AbstractTwoPointTool(parent)
+  , m_cacheSize(0)
 {}
 
 QIcon PixelateTool::icon(const QColor& background, bool inEditor) const
@@ -46,43 +49,40 @@ CaptureTool* PixelateTool::copy(QObject* parent)
     return tool;
 }
 
-void PixelateTool::process(QPainter& painter, const QPixmap& pixmap)
+void PixelateTool::process(QPainter& painter, const TiledPixmap& pixmap)
 {
     QRect selection = boundingRect().intersected(pixmap.rect());
     auto pixelRatio = pixmap.devicePixelRatio();
     QRect selectionScaled = QRect(selection.topLeft() * pixelRatio,
                                   selection.bottomRight() * pixelRatio);
 
-    // If thickness is less than 1, use old blur process
-    if (size() <= 1) {
-        auto* blur = new QGraphicsBlurEffect;
-        blur->setBlurRadius(10);
-        auto* item = new QGraphicsPixmapItem(pixmap.copy(selectionScaled));
-        item->setGraphicsEffect(blur);
-
-        QGraphicsScene scene;
-        scene.addItem(item);
-
-        scene.render(&painter, selection, QRectF());
-        blur->setBlurRadius(12);
-        // multiple repeat for make blur effect stronger
-        scene.render(&painter, selection, QRectF());
+    painter.drawImage(selection, filtered(pixmap, selectionScaled));
+}
 
+QImage PixelateTool::filtered(const TiledPixmap& pixmap, const QRect& rect)
+{
+    QVector<qint64> keys = pixmap.cacheKeys(rect);
+    if (!m_cache.isNull() && rect == m_cacheRect && size() == m_cacheSize &&
+        keys == m_cacheKeys) {
+        return m_cache;
+    }
+    const qreal ratio = pixmap.devicePixelRatio();
+    m_cache = pixmap.copy(rect).toImage();
+    // If thickness is less than 1, blur instead of pixelating
+    if (size() <= 1) {
+        ImageFilters::blur(m_cache, BLUR_SIGMA * ratio);
     } else {
-        int width =
-          static_cast<int>(selection.width() * (0.5 / qMax(1, size() + 1)));
-        int height =
-          static_cast<int>(selection.height() * (0.5 / qMax(1, size() + 1)));
-        QSize size = QSize(qMax(width, 1), qMax(height, 1));
-
-        QPixmap t = pixmap.copy(selectionScaled);
-        t = t.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-        t = t.scaled(selection.width(), selection.height());
-        painter.drawImage(selection, t.toImage());
+        // Same block size as the former downscaling by 0.5 / (size + 1)
+        const int blockSize = qRound(2 * (size() + 1) * ratio);
+        ImageFilters::pixelate(m_cache, qMax(1, blockSize));
     }
+    m_cacheRect = rect;
+    m_cacheSize = size();
+    m_cacheKeys = keys;
+    return m_cache;
 }
 
-void PixelateTool::drawSearchArea(QPainter& painter, const QPixmap& pixmap)
+void PixelateTool::drawSearchArea(QPainter& painter, const TiledPixmap& pixmap)
 {
     Q_UNUSED(pixmap)
     painter.fillRect(boundingRect(), QBrush(Qt::black));
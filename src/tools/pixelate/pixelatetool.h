@@ -4,6 +4,8 @@
 #pragma once
 
 #include "src/tools/abstracttwopointtool.h"
+#include <QImage>
+#include <QVector>
 
 class PixelateTool : public AbstractTwoPointTool
 {
@@ -15,10 +17,11 @@ public:
     QString name() const override;
     QString description() const override;
     QRect boundingRect() const override;
+    bool readsBackground() const override { return true; };
 
     CaptureTool* copy(QObject* parent = nullptr) override;
-    void process(QPainter& painter, const QPixmap& pixmap) override;
-    void drawSearchArea(QPainter& painter, const QPixmap& pixmap) override;
+    void process(QPainter& painter, const TiledPixmap& pixmap) override;
+    void drawSearchArea(QPainter& painter, const TiledPixmap& pixmap) override;
     void paintMousePreview(QPainter& painter,
                            const CaptureContext& context) override;
 
@@ -27,4 +30,14 @@ protected:
 
 public slots:
     void pressed(CaptureContext& context) override;
+
+private:
+    QImage filtered(const TiledPixmap& pixmap, const QRect& rect);
+
+    // Result of the last pixelation or blur, process() is called for every
+    // tile and on every repaint while the pixels beneath usually stay the same
+    QImage m_cache;
+    QRect m_cacheRect;
+    int m_cacheSize;
+    QVector<qint64> m_cacheKeys;
 };
@@ -193,7 +193,7 @@ CaptureTool* TextTool::copy(QObject* parent)
     return textTool;
 }
 
-void TextTool::process(QPainter& painter, const QPixmap& pixmap)
+void TextTool::process(QPainter& painter, const TiledPixmap& pixmap)
 {
     Q_UNUSED(pixmap)
     if (m_text.isEmpty()) {
@@ -351,6 +351,12 @@ void TextTool::setEditMode(bool editMode)
     CaptureTool::setEditMode(editMode);
 }
 
+qint64 TextTool::memoryUsage() const
+{
+    return sizeof(TextTool) +
+           (m_text.capacity() + m_textOld.capacity()) * sizeof(QChar);
+}
+
 bool TextTool::isChanged()
 {
     return QString::compare(m_text, m_textOld, Qt::CaseInsensitive) != 0;
@@ -33,7 +33,7 @@ public:
     QWidget* configurationWidget() override;
     CaptureTool* copy(QObject* parent = nullptr) override;
 
-    void process(QPainter& painter, const QPixmap& pixmap) override;
+    void process(QPainter& painter, const TiledPixmap& pixmap) override;
     void paintMousePreview(QPainter& painter,
                            const CaptureContext& context) override;
     void move(const QPoint& pos) override;
@@ -42,6 +42,7 @@ public:
 
     void setEditMode(bool editMode) override;
     bool isChanged() override;
+    [[nodiscard]] qint64 memoryUsage() const override;
 
 protected:
     void copyParams(const TextTool* from, TextTool* to);
@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "capturemimedata.h"
+#include "src/utils/confighandler.h"
+
+// The MIME type of images in Qt, converted by the platform plugins
+#define QT_IMAGE_TYPE "application/x-qt-image"
+
+CaptureMimeData::CaptureMimeData(const EncodedCapture& capture,
+                                 const QString& preferredType)
+  : m_capture(capture)
+  , m_jpegQuality(ConfigHandler().jpegQuality())
+{
+    m_formats << "image/" + preferredType;
+    for (const char* type : { "png", "jpeg", "bmp" }) {
+        if (preferredType != type) {
+            m_formats << QStringLiteral("image/") + type;
+        }
+    }
+#if defined(Q_OS_WIN) || defined(Q_OS_MACOS)
+    // The Windows and macOS plugins make their bitmaps from the image. The X11
+    // one would encode the image files itself instead of asking for them, the
+    // image is only retrieved in this process there.
+    m_formats << QT_IMAGE_TYPE;
+#endif
+}
+
+QStringList CaptureMimeData::formats() const
+{
+    return m_formats;
+}
+
+bool CaptureMimeData::hasFormat(const QString& mimeType) const
+{
+    return m_formats.contains(mimeType);
+}
+
+QVariant CaptureMimeData::retrieveData(const QString& mimeType,
+                                       QVariant::Type preferredType) const
+{
+    if (mimeType == QT_IMAGE_TYPE) {
+        return m_capture.image();
+    }
+    if (!mimeType.startsWith("image/") || !m_formats.contains(mimeType)) {
+        return QMimeData::retrieveData(mimeType, preferredType);
+    }
+    return m_capture.encodedAs(mimeType.mid(6).toLatin1(), m_jpegQuality);
+}
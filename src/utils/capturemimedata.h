@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include "src/utils/encodedcapture.h"
+#include <QMimeData>
+#include <QStringList>
+
+/**
+ * @brief Clipboard contents of a capture, encoded when they are pasted.
+ *
+ * The capture is offered as PNG, JPEG and BMP files, and as an image to the
+ * platforms converting it to their own formats. Nothing is encoded when it is
+ * put on the clipboard: a format is encoded the first time a consumer asks
+ * for it, through the EncodedCapture, which keeps it for the next requests
+ * and for the other sinks of the capture.
+ */
+class CaptureMimeData : public QMimeData
+{
+public:
+    // `preferredType` ("png", "jpeg"...) is offered first
+    CaptureMimeData(const EncodedCapture& capture,
+                    const QString& preferredType = QStringLiteral("png"));
+
+    QStringList formats() const override;
+    bool hasFormat(const QString& mimeType) const override;
+
+protected:
+    QVariant retrieveData(const QString& mimeType,
+                          QVariant::Type preferredType) const override;
+
+private:
+    EncodedCapture m_capture;
+    QStringList m_formats;
+    int m_jpegQuality;
+};
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "codecs.h"
+#include "src/utils/pngwriter.h"
+#include "src/utils/qoiwriter.h"
+#include <QBuffer>
+#include <QImageWriter>
+#include <QMimeDatabase>
+
+// Qt's WebP plugin writes lossless files at this quality
+#define WEBP_LOSSLESS_QUALITY 100
+
+Codecs::Preset Codecs::preset(const QString& name)
+{
+    const int index = presetNames().indexOf(name.toLower());
+    return index < 0 ? Balanced : static_cast<Preset>(index);
+}
+
+QStringList Codecs::presetNames()
+{
+    // In the order of the enum
+    return { QStringLiteral("fastest"),
+             QStringLiteral("balanced"),
+             QStringLiteral("smallest") };
+}
+
+QStringList Codecs::formats()
+{
+    QStringList formats;
+    for (const QByteArray& format : QImageWriter::supportedImageFormats()) {
+        formats.append(format);
+    }
+    if (!formats.contains(QStringLiteral("qoi"))) {
+        formats.append(QStringLiteral("qoi"));
+    }
+    return formats;
+}
+
+QByteArray Codecs::normalizedFormat(const QByteArray& format)
+{
+    const QByteArray lower = format.toLower();
+    return lower == "jpg" ? QByteArrayLiteral("jpeg") : lower;
+}
+
+QString Codecs::mimeType(const QByteArray& format)
+{
+    const QByteArray normalized = normalizedFormat(format);
+    if (normalized == "qoi") {
+        // Not known to older shared-mime-info versions
+        return QStringLiteral("image/qoi");
+    }
+    const QMimeType type =
+      QMimeDatabase().mimeTypeForFile("image." + normalized);
+    return type.isDefault() ? QStringLiteral("image/") + normalized
+                            : type.name();
+}
+
+QByteArray Codecs::encode(const QImage& image,
+                          const QByteArray& format,
+                          int quality,
+                          Preset preset,
+                          int pngLevel)
+{
+    const QByteArray normalized = normalizedFormat(format);
+    if (normalized == "png") {
+        int level = pngLevel;
+        if (preset == Fastest) {
+            level = 1;
+        } else if (preset == Smallest) {
+            level = 9;
+        }
+        return PngWriter::encode(image, level);
+    }
+    if (normalized == "qoi") {
+        return QoiWriter::encode(image);
+    }
+
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    QImageWriter writer(&buffer, normalized);
+    writer.setQuality(normalized == "webp" ? WEBP_LOSSLESS_QUALITY : quality);
+    if (!writer.write(image)) {
+        return QByteArray();
+    }
+    return data;
+}
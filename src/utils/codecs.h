@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+#include <QStringList>
+
+// The image formats captures are exported to, and how fast they are encoded.
+namespace Codecs {
+
+// Trade between the encoding time and the file size
+enum Preset
+{
+    // Fastest encoding: PNG at level 1
+    Fastest,
+    // PNG at the pngCompressionLevel of the config
+    Balanced,
+    // Smallest files: PNG at level 9
+    Smallest,
+};
+
+// The preset named `name` ("fastest", "balanced", "smallest"), Balanced when
+// there is none
+Preset preset(const QString& name);
+// Names of the presets
+QStringList presetNames();
+
+// Formats captures can be encoded to: the ones of QImageWriter and QOI
+QStringList formats();
+// Lower case `format`, with "jpg" as "jpeg"
+QByteArray normalizedFormat(const QByteArray& format);
+// The MIME type of `format`, image/<format> when it is not known
+QString mimeType(const QByteArray& format);
+
+// Encode `image` as `format`, with `quality` for the lossy formats. PNG is
+// compressed at the level of `preset`, `pngLevel` for Balanced, WebP is
+// lossless. Returns an empty array on failure.
+QByteArray encode(const QImage& image,
+                  const QByteArray& format,
+                  int quality,
+                  Preset preset,
+                  int pngLevel);
+
+} // namespace Codecs
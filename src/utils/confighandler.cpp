@@ -85,9 +85,15 @@ static QMap<class QString, QSharedPointer<ValueHandler>>
     OPTION("allowMultipleGuiInstances"   ,Bool               ( false         )),
     OPTION("showMagnifier"               ,Bool               ( false         )),
     OPTION("squareMagnifier"             ,Bool               ( false         )),
+    OPTION("snapToWindows"               ,Bool               ( false         )),
+    OPTION("magneticSelection"           ,Bool               ( false         )),
 #if !defined(Q_OS_WIN)
     OPTION("autoCloseIdleDaemon"         ,Bool               ( false         )),
 #endif
+    OPTION("retroactiveCapture"          ,Bool               ( false         )),
+    OPTION("retroactiveCaptureInterval"  ,BoundedInt         (250, 10000, 1000)),
+    OPTION("retroactiveCaptureDuration"  ,BoundedInt         (1, 3600, 60    )),
+    OPTION("retroactiveCaptureMemoryLimit",BoundedInt        (8, 4096, 128   )),
     OPTION("startupLaunch"               ,Bool               ( false         )),
     OPTION("showStartupLaunchMessage"    ,Bool               ( true          )),
     OPTION("copyURLAfterUpload"          ,Bool               ( true          )),
@@ -102,6 +108,7 @@ static QMap<class QString, QSharedPointer<ValueHandler>>
     OPTION("saveLastRegion"              ,Bool               (false          )),
     OPTION("uploadHistoryMax"            ,LowerBoundedInt    (0, 25               )),
     OPTION("undoLimit"                   ,BoundedInt         (0, 999, 100    )),
+    OPTION("undoMemoryLimit"             ,BoundedInt         (0, 4096, 0     )),
   // Interface tab
     OPTION("uiColor"                     ,Color              ( {116, 0, 150}   )),
     OPTION("contrastUiColor"             ,Color              ( {39, 0, 50}     )),
@@ -140,6 +147,10 @@ static QMap<class QString, QSharedPointer<ValueHandler>>
     OPTION("showSelectionGeometry"  , BoundedInt               (0,5,4)),
     OPTION("showSelectionGeometryHideTime", LowerBoundedInt       (0, 3000)),
     OPTION("jpegQuality", BoundedInt     (0,100,75)),
+    OPTION("pngCompressionLevel", BoundedInt(0,9,6)),
+    OPTION("encodingPreset", EncodingPreset()),
+    OPTION("clipboardFormat", ImageFormat("png")),
+    OPTION("uploadFormat", ImageFormat("png")),
     OPTION("platform", String            ( "default"            )),
 
     // Endpoints
@@ -98,6 +98,16 @@ public:
                          setAllowMultipleGuiInstances,
                          bool)
     CONFIG_GETTER_SETTER(autoCloseIdleDaemon, setAutoCloseIdleDaemon, bool)
+    CONFIG_GETTER_SETTER(retroactiveCapture, setRetroactiveCapture, bool)
+    CONFIG_GETTER_SETTER(retroactiveCaptureInterval,
+                         setRetroactiveCaptureInterval,
+                         int)
+    CONFIG_GETTER_SETTER(retroactiveCaptureDuration,
+                         setRetroactiveCaptureDuration,
+                         int)
+    CONFIG_GETTER_SETTER(retroactiveCaptureMemoryLimit,
+                         setRetroactiveCaptureMemoryLimit,
+                         int)
     CONFIG_GETTER_SETTER(showStartupLaunchMessage,
                          setShowStartupLaunchMessage,
                          bool)
@@ -119,9 +129,12 @@ public:
                          setIgnoreUpdateToVersion,
                          QString)
     CONFIG_GETTER_SETTER(undoLimit, setUndoLimit, int)
+    CONFIG_GETTER_SETTER(undoMemoryLimit, setUndoMemoryLimit, int)
     CONFIG_GETTER_SETTER(buttons, setButtons, QList<CaptureTool::Type>)
     CONFIG_GETTER_SETTER(showMagnifier, setShowMagnifier, bool)
     CONFIG_GETTER_SETTER(squareMagnifier, setSquareMagnifier, bool)
+    CONFIG_GETTER_SETTER(snapToWindows, setSnapToWindows, bool)
+    CONFIG_GETTER_SETTER(magneticSelection, setMagneticSelection, bool)
     CONFIG_GETTER_SETTER(copyOnDoubleClick, setCopyOnDoubleClick, bool)
     CONFIG_GETTER_SETTER(uploadClientSecret, setUploadClientSecret, QString)
     CONFIG_GETTER_SETTER(uploadTokenTPU, setUploadTokenTPU, QString)
@@ -150,6 +163,10 @@ public:
     CONFIG_GETTER_SETTER(saveLastRegion, setSaveLastRegion, bool)
     CONFIG_GETTER_SETTER(showSelectionGeometry, setShowSelectionGeometry, int)
     CONFIG_GETTER_SETTER(jpegQuality, setJpegQuality, int)
+    CONFIG_GETTER_SETTER(pngCompressionLevel, setPngCompressionLevel, int)
+    CONFIG_GETTER_SETTER(encodingPreset, setEncodingPreset, QString)
+    CONFIG_GETTER_SETTER(clipboardFormat, setClipboardFormat, QString)
+    CONFIG_GETTER_SETTER(uploadFormat, setUploadFormat, QString)
     CONFIG_GETTER_SETTER(showSelectionGeometryHideTime,
                          showSelectionGeometryHideTime,
                          int)
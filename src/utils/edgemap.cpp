@@ -0,0 +1,265 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "edgemap.h"
+#include "src/utils/imagefilters.h"
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+#include <cstdlib>
+#include <utility>
+
+// Side of the square tiles of the gradient, in device pixels
+#define TILE_SIZE 128
+// Distance to the cursor within which the gradient is computed in advance,
+// in device pixels
+#define PREFETCH_DISTANCE 64
+// Distance within which the sides snap to an edge, in logical pixels
+#define SNAP_DISTANCE 8
+// Gradient magnitude of an edge, roughly a luma step of that much
+#define EDGE_STRENGTH 24
+// Percentage of the samples of a line that must be on an edge
+#define EDGE_COVERAGE 60
+// Points of a line that are sampled
+#define EDGE_SAMPLES 64
+
+struct EdgeMap::Tile
+{
+    int width = 0;
+    QByteArray horizontal;
+    QByteArray vertical;
+};
+
+struct EdgeMap::State
+{
+    mutable QMutex mutex;
+    QHash<int, Tile> tiles;
+};
+
+class EdgeMap::SobelTask : public QRunnable
+{
+public:
+    SobelTask(QSharedPointer<State> state,
+              int index,
+              const QImage& image,
+              const QRect& area)
+      : m_state(std::move(state))
+      , m_index(index)
+      , m_image(image)
+      , m_area(area)
+    {}
+
+    void run() override
+    {
+        Tile tile;
+        tile.width = m_area.width();
+        ImageFilters::sobel(m_image, m_area, tile.horizontal, tile.vertical);
+        QMutexLocker locker(&m_state->mutex);
+        m_state->tiles.insert(m_index, tile);
+    }
+
+private:
+    QSharedPointer<State> m_state;
+    int m_index;
+    QImage m_image;
+    QRect m_area;
+};
+
+EdgeMap::EdgeMap()
+  : m_columns(0)
+  , m_state(new State())
+{}
+
+void EdgeMap::setSource(const TiledPixmap& source)
+{
+    m_source = source;
+    m_columns = (source.width() + TILE_SIZE - 1) / TILE_SIZE;
+    m_requested.clear();
+    // Tasks still running for the previous source fill the previous state
+    m_state.reset(new State());
+}
+
+bool EdgeMap::isNull() const
+{
+    return m_source.isNull();
+}
+
+void EdgeMap::prefetch(const QPoint& pos)
+{
+    if (isNull()) {
+        return;
+    }
+    const QPoint center = pos * m_source.devicePixelRatio();
+    const QPoint distance(PREFETCH_DISTANCE, PREFETCH_DISTANCE);
+    request(QRect(center - distance, center + distance));
+}
+
+int EdgeMap::snap(Qt::Orientation orientation, int position, int from, int to)
+{
+    if (isNull()) {
+        return position;
+    }
+    const qreal ratio = m_source.devicePixelRatio();
+    const int line = qRound(position * ratio);
+    const int first = qRound(from * ratio);
+    const int last = qRound((to + 1) * ratio) - 1;
+    const int distance = qRound(SNAP_DISTANCE * ratio);
+
+    int found = -1;
+    QSet<int> missing;
+    {
+        QMutexLocker locker(&m_state->mutex);
+        for (int d = 0; d <= distance && found < 0; ++d) {
+            if (isEdge(*m_state, orientation, line - d, first, last, missing)) {
+                found = line - d;
+            } else if (isEdge(*m_state,
+                              orientation,
+                              line + d,
+                              first,
+                              last,
+                              missing)) {
+                found = line + d;
+            }
+        }
+    }
+    request(missing);
+    return found < 0 ? position : qRound(found / ratio);
+}
+
+int EdgeMap::next(Qt::Orientation orientation,
+                  int position,
+                  int step,
+                  int from,
+                  int to)
+{
+    if (isNull()) {
+        return position + step;
+    }
+    const qreal ratio = m_source.devicePixelRatio();
+    const int line = qRound(position * ratio);
+    const int first = qRound(from * ratio);
+    const int last = qRound((to + 1) * ratio) - 1;
+    const int distance = qRound(SNAP_DISTANCE * ratio);
+
+    int current = line + step;
+    QSet<int> missing;
+    {
+        QMutexLocker locker(&m_state->mutex);
+        const auto edge = [&](int candidate) {
+            return isEdge(
+              *m_state, orientation, candidate, first, last, missing);
+        };
+        // Leave the edge the side is on first
+        if (edge(line)) {
+            while (std::abs(current - line) <= distance && edge(current)) {
+                current += step;
+            }
+        }
+        while (std::abs(current - line) <= distance && !edge(current)) {
+            current += step;
+        }
+    }
+    request(missing);
+    if (std::abs(current - line) > distance) {
+        return position + step;
+    }
+    const int result = qRound(current / ratio);
+    return result == position ? position + step : result;
+}
+
+bool EdgeMap::isEdge(const State& state,
+                     Qt::Orientation orientation,
+                     int line,
+                     int from,
+                     int to,
+                     QSet<int>& missing) const
+{
+    const bool vertical = orientation == Qt::Vertical;
+    const int length = vertical ? m_source.height() : m_source.width();
+    if (line < 0 || line >= (vertical ? m_source.width() : m_source.height())) {
+        return false;
+    }
+    from = qMax(0, from);
+    to = qMin(length - 1, to);
+    if (from > to) {
+        return false;
+    }
+
+    const int samples = qMin(EDGE_SAMPLES, to - from + 1);
+    int strong = 0;
+    int index = -1;
+    const Tile* tile = nullptr;
+    for (int i = 0; i < samples; ++i) {
+        const int along =
+          samples > 1 ? from + (to - from) * i / (samples - 1) : from;
+        const int x = vertical ? line : along;
+        const int y = vertical ? along : line;
+        const int tileIndex = y / TILE_SIZE * m_columns + x / TILE_SIZE;
+        if (tileIndex != index) {
+            index = tileIndex;
+            auto found = state.tiles.constFind(index);
+            tile = found != state.tiles.constEnd() ? &found.value() : nullptr;
+            if (tile == nullptr) {
+                missing.insert(index);
+            }
+        }
+        if (tile == nullptr) {
+            continue;
+        }
+        // A vertical line is an edge where the x derivative is high
+        const QByteArray& gradient =
+          vertical ? tile->horizontal : tile->vertical;
+        const int offset = (y % TILE_SIZE) * tile->width + x % TILE_SIZE;
+        if (static_cast<uchar>(gradient.at(offset)) >= EDGE_STRENGTH) {
+            ++strong;
+        }
+    }
+    return strong * 100 >= samples * EDGE_COVERAGE;
+}
+
+void EdgeMap::request(const QRect& rect)
+{
+    const QRect area = rect.intersected(m_source.rect());
+    if (area.isEmpty()) {
+        return;
+    }
+    QSet<int> tiles;
+    for (int row = area.top() / TILE_SIZE; row <= area.bottom() / TILE_SIZE;
+         ++row) {
+        for (int column = area.left() / TILE_SIZE;
+             column <= area.right() / TILE_SIZE;
+             ++column) {
+            tiles.insert(row * m_columns + column);
+        }
+    }
+    request(tiles);
+}
+
+void EdgeMap::request(const QSet<int>& tiles)
+{
+    for (int index : tiles) {
+        if (m_requested.contains(index)) {
+            continue;
+        }
+        m_requested.insert(index);
+        const QRect tile = QRect(index % m_columns * TILE_SIZE,
+                                 index / m_columns * TILE_SIZE,
+                                 TILE_SIZE,
+                                 TILE_SIZE)
+                             .intersected(m_source.rect());
+        // The gradient of the border pixels depends on their neighbours.
+        // QPixmap can only be read in this thread, the small copy converted
+        // to an image is what the task works on.
+        const QRect copied =
+          tile.adjusted(-1, -1, 1, 1).intersected(m_source.rect());
+        QThreadPool::globalInstance()->start(
+          new SobelTask(m_state,
+                        index,
+                        m_source.copy(copied).toImage(),
+                        tile.translated(-copied.topLeft())));
+    }
+}
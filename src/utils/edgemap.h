@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include "src/utils/tiledpixmap.h"
+#include <QPoint>
+#include <QRect>
+#include <QSet>
+#include <QSharedPointer>
+
+/**
+ * @brief Strong edges of the screenshot, to snap the sides of the selection
+ * to panel borders, table lines and the like.
+ *
+ * The gradient of the screenshot is computed lazily by tiles, in background
+ * threads, around the cursor and along the sides being moved. Queries never
+ * wait for it: a line whose tiles are not computed yet is not an edge, it
+ * becomes one a few events later.
+ *
+ * Positions are in logical pixels of the screenshot. An edge `orientation`
+ * is the orientation of the line, Qt::Vertical for the left and right sides.
+ */
+class EdgeMap
+{
+public:
+    EdgeMap();
+
+    void setSource(const TiledPixmap& source);
+    bool isNull() const;
+
+    // Compute the edges around `pos` in the background
+    void prefetch(const QPoint& pos);
+    // The edge spanning [from, to] nearest to `position`, `position` when
+    // none is close enough
+    int snap(Qt::Orientation orientation, int position, int from, int to);
+    // The next edge spanning [from, to] after `position` in the direction of
+    // `step` (-1 or 1), `position + step` when none is close enough
+    int next(Qt::Orientation orientation,
+             int position,
+             int step,
+             int from,
+             int to);
+
+private:
+    struct Tile;
+    struct State;
+    class SobelTask;
+
+    // Whether the line `line` (device pixels) is an edge over [from, to],
+    // the tiles it needs that are not computed yet are added to `missing`
+    bool isEdge(const State& state,
+                Qt::Orientation orientation,
+                int line,
+                int from,
+                int to,
+                QSet<int>& missing) const;
+    // Compute the tiles intersecting `rect` (device pixels)
+    void request(const QRect& rect);
+    void request(const QSet<int>& tiles);
+
+    // class members
+    TiledPixmap m_source;
+    int m_columns;
+    // Tiles computed or being computed
+    QSet<int> m_requested;
+    QSharedPointer<State> m_state;
+};
@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "encodedcapture.h"
+#include "src/utils/confighandler.h"
+#include <QFileInfo>
+#include <QMutexLocker>
+
+using Codecs::normalizedFormat;
+
+namespace {
+
+QByteArray fileKey(const QByteArray& format, int quality)
+{
+    return format + ':' + QByteArray::number(quality);
+}
+
+} // namespace
+
+EncodedCapture::EncodedCapture()
+  : m_data(new Data())
+{
+    // The config can't be read from the threads encoding the capture
+    ConfigHandler config;
+    m_data->preset = Codecs::preset(config.encodingPreset());
+    m_data->pngLevel = config.pngCompressionLevel();
+}
+
+EncodedCapture::EncodedCapture(const QPixmap& capture)
+  : EncodedCapture()
+{
+    m_data->pixmap = capture;
+    // Shares the pixels of a raster pixmap, it is not copied
+    m_data->image = capture.toImage();
+}
+
+EncodedCapture EncodedCapture::fromData(const QByteArray& data,
+                                        const QByteArray& format)
+{
+    EncodedCapture capture;
+    const QByteArray normalized = normalizedFormat(format);
+    if (capture.m_data->pixmap.loadFromData(data, normalized.constData())) {
+        capture.m_data->image = capture.m_data->pixmap.toImage();
+        capture.m_data->files.insert(fileKey(normalized, -1), data);
+    }
+    return capture;
+}
+
+bool EncodedCapture::isNull() const
+{
+    return m_data->pixmap.isNull();
+}
+
+const QPixmap& EncodedCapture::pixmap() const
+{
+    return m_data->pixmap;
+}
+
+const QImage& EncodedCapture::image() const
+{
+    return m_data->image;
+}
+
+QByteArray EncodedCapture::encoded(const QByteArray& format, int quality) const
+{
+    const QByteArray normalized = normalizedFormat(format);
+    const QByteArray key = fileKey(normalized, quality);
+    // Held while encoding, a format asked by two threads is encoded once
+    QMutexLocker locker(&m_data->mutex);
+    auto found = m_data->files.constFind(key);
+    if (found != m_data->files.constEnd()) {
+        return found.value();
+    }
+
+    const QByteArray data = Codecs::encode(
+      m_data->image, normalized, quality, m_data->preset, m_data->pngLevel);
+    if (!data.isEmpty()) {
+        m_data->files.insert(key, data);
+    }
+    return data;
+}
+
+QByteArray EncodedCapture::encodedAs(const QByteArray& format,
+                                     int jpegQuality) const
+{
+    const QByteArray normalized = normalizedFormat(format);
+    return encoded(normalized, normalized == "jpeg" ? jpegQuality : -1);
+}
+
+QByteArray EncodedCapture::encodedFor(const QString& path,
+                                      int jpegQuality) const
+{
+    QByteArray format = QFileInfo(path).suffix().toLatin1();
+    if (format.isEmpty()) {
+        format = "png";
+    }
+    return encodedAs(format, jpegQuality);
+}
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include "src/utils/codecs.h"
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QPixmap>
+#include <QSharedPointer>
+#include <QString>
+
+/**
+ * @brief A capture and the files it was encoded to, so that exporting it to
+ * several places (file, clipboard, upload, stdout) encodes each format once.
+ *
+ * Copies share the encoded files: the first sink asking for a format pays for
+ * the encoding, the following ones get the same implicitly shared QByteArray.
+ * A QPixmap converts implicitly, in which case nothing is shared.
+ *
+ * The files are written by Codecs with the encoding preset and PNG compression
+ * level of the config at construction.
+ *
+ * `encoded` may be called from any thread, the capture is encoded from an
+ * image taken from the pixmap when it is constructed. The pixmap itself must
+ * only be used, and the last copy destroyed, in the GUI thread.
+ */
+class EncodedCapture
+{
+public:
+    EncodedCapture();
+    EncodedCapture(const QPixmap& capture);
+
+    // A capture decoded from `data`, which is kept as its `format` encoding
+    static EncodedCapture fromData(const QByteArray& data,
+                                   const QByteArray& format);
+
+    bool isNull() const;
+    const QPixmap& pixmap() const;
+    const QImage& image() const;
+
+    // The capture encoded as `format` ("png", "jpg", "qoi"...), empty on
+    // failure
+    QByteArray encoded(const QByteArray& format, int quality = -1) const;
+    // The capture encoded as `format`, with `jpegQuality` for JPEG
+    QByteArray encodedAs(const QByteArray& format, int jpegQuality) const;
+    // The capture encoded for a file named `path`, in the format of its
+    // suffix, with `jpegQuality` for JPEG
+    QByteArray encodedFor(const QString& path, int jpegQuality) const;
+
+private:
+    struct Data
+    {
+        QPixmap pixmap;
+        QImage image;
+        Codecs::Preset preset = Codecs::Balanced;
+        int pngLevel = 6;
+        QMutex mutex;
+        QHash<QByteArray, QByteArray> files;
+    };
+
+    QSharedPointer<Data> m_data;
+};
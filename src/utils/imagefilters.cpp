@@ -0,0 +1,438 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "imagefilters.h"
+#include "src/utils/strips.h"
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                   \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define USE_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(USE_SSE2) && defined(__AVX2__)
+#define USE_AVX2
+#include <immintrin.h>
+#endif
+
+// Each 16 bits lane of a partial sum receives two 8 bits channels per load,
+// so 128 loads can be added before the lanes must be widened to 32 bits
+#define PARTIAL_SUM_LOADS 128
+
+// Number of box blurs used to approximate a gaussian blur
+#define BLUR_PASSES 3
+// Minimum number of rows (or columns) handled by a thread
+#define MIN_STRIP_SIZE 32
+
+namespace {
+
+void prepare(QImage& image)
+{
+    if (image.format() != QImage::Format_ARGB32_Premultiplied) {
+        image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+}
+
+// Add the channels of `count` pixels to `sums`, sums[i] receives the channel
+// stored in bits 8 * i of the pixels (blue, green, red, alpha)
+void sumPixels(const quint32* pixels, int count, quint32* sums)
+{
+    int i = 0;
+#ifdef USE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    __m128i total = zero;
+#ifdef USE_AVX2
+    const __m256i zero256 = _mm256_setzero_si256();
+    __m256i total256 = zero256;
+    while (i + 8 <= count) {
+        __m256i partial = zero256;
+        const int end = qMin(count, i + 8 * PARTIAL_SUM_LOADS);
+        for (; i + 8 <= end; i += 8) {
+            const __m256i v =
+              _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i));
+            partial = _mm256_add_epi16(
+              partial,
+              _mm256_add_epi16(_mm256_unpacklo_epi8(v, zero256),
+                               _mm256_unpackhi_epi8(v, zero256)));
+        }
+        total256 = _mm256_add_epi32(
+          total256,
+          _mm256_add_epi32(_mm256_unpacklo_epi16(partial, zero256),
+                           _mm256_unpackhi_epi16(partial, zero256)));
+    }
+    total = _mm_add_epi32(_mm256_castsi256_si128(total256),
+                          _mm256_extracti128_si256(total256, 1));
+#endif
+    while (i + 4 <= count) {
+        __m128i partial = zero;
+        const int end = qMin(count, i + 4 * PARTIAL_SUM_LOADS);
+        for (; i + 4 <= end; i += 4) {
+            const __m128i v =
+              _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i));
+            partial = _mm_add_epi16(partial,
+                                    _mm_add_epi16(_mm_unpacklo_epi8(v, zero),
+                                                  _mm_unpackhi_epi8(v, zero)));
+        }
+        total =
+          _mm_add_epi32(total,
+                        _mm_add_epi32(_mm_unpacklo_epi16(partial, zero),
+                                      _mm_unpackhi_epi16(partial, zero)));
+    }
+    alignas(16) quint32 lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), total);
+    for (int c = 0; c < 4; ++c) {
+        sums[c] += lanes[c];
+    }
+#endif
+    for (; i < count; ++i) {
+        const quint32 pixel = pixels[i];
+        for (int c = 0; c < 4; ++c) {
+            sums[c] += (pixel >> (8 * c)) & 0xff;
+        }
+    }
+}
+
+#ifdef USE_SSE2
+// Channels of a pixel in 32 bits lanes
+struct Channels
+{
+    __m128i v;
+};
+
+inline Channels zeroChannels()
+{
+    return { _mm_setzero_si128() };
+}
+
+inline Channels unpackPixel(quint32 pixel)
+{
+    const __m128i zero = _mm_setzero_si128();
+    return { _mm_unpacklo_epi16(
+      _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(pixel)), zero),
+      zero) };
+}
+
+inline Channels addChannels(Channels a, Channels b)
+{
+    return { _mm_add_epi32(a.v, b.v) };
+}
+
+inline Channels subtractChannels(Channels a, Channels b)
+{
+    return { _mm_sub_epi32(a.v, b.v) };
+}
+
+inline quint32 packPixel(Channels sum, float scale)
+{
+    __m128i v = _mm_cvtps_epi32(
+      _mm_mul_ps(_mm_cvtepi32_ps(sum.v), _mm_set1_ps(scale)));
+    v = _mm_packs_epi32(v, v);
+    return static_cast<quint32>(_mm_cvtsi128_si32(_mm_packus_epi16(v, v)));
+}
+#else
+struct Channels
+{
+    qint32 c[4];
+};
+
+inline Channels zeroChannels()
+{
+    return { { 0, 0, 0, 0 } };
+}
+
+inline Channels unpackPixel(quint32 pixel)
+{
+    return { { static_cast<qint32>(pixel & 0xff),
+               static_cast<qint32>((pixel >> 8) & 0xff),
+               static_cast<qint32>((pixel >> 16) & 0xff),
+               static_cast<qint32>(pixel >> 24) } };
+}
+
+inline Channels addChannels(Channels a, Channels b)
+{
+    for (int i = 0; i < 4; ++i) {
+        a.c[i] += b.c[i];
+    }
+    return a;
+}
+
+inline Channels subtractChannels(Channels a, Channels b)
+{
+    for (int i = 0; i < 4; ++i) {
+        a.c[i] -= b.c[i];
+    }
+    return a;
+}
+
+inline quint32 packPixel(Channels sum, float scale)
+{
+    quint32 pixel = 0;
+    for (int i = 0; i < 4; ++i) {
+        const int value = qBound(0, qRound(sum.c[i] * scale), 255);
+        pixel |= static_cast<quint32>(value) << (8 * i);
+    }
+    return pixel;
+}
+#endif
+
+// Raw access to the scanlines, QImage::scanLine() isn't thread safe
+struct Pixels
+{
+    uchar* bits;
+    qptrdiff bytesPerLine;
+
+    quint32* line(int y) const
+    {
+        return reinterpret_cast<quint32*>(bits + y * bytesPerLine);
+    }
+};
+
+// Box blur of the rows [begin, end) from `source` into `target`
+void boxBlurRows(const Pixels& source,
+                 const Pixels& target,
+                 int width,
+                 int radius,
+                 int begin,
+                 int end)
+{
+    const float scale = 1.0f / (2 * radius + 1);
+    for (int y = begin; y < end; ++y) {
+        const quint32* in = source.line(y);
+        quint32* out = target.line(y);
+        Channels sum = zeroChannels();
+        for (int i = -radius; i <= radius; ++i) {
+            sum = addChannels(sum, unpackPixel(in[qBound(0, i, width - 1)]));
+        }
+        for (int x = 0; x < width; ++x) {
+            out[x] = packPixel(sum, scale);
+            sum = addChannels(
+              sum, unpackPixel(in[qMin(x + radius + 1, width - 1)]));
+            sum = subtractChannels(sum, unpackPixel(in[qMax(x - radius, 0)]));
+        }
+    }
+}
+
+// Box blur of the columns [begin, end) from `source` into `target`, the
+// image is read row by row to stay cache friendly
+void boxBlurColumns(const Pixels& source,
+                    const Pixels& target,
+                    int height,
+                    int radius,
+                    int begin,
+                    int end)
+{
+    const float scale = 1.0f / (2 * radius + 1);
+    std::vector<Channels> sums(end - begin, zeroChannels());
+    for (int i = -radius; i <= radius; ++i) {
+        const quint32* in = source.line(qBound(0, i, height - 1));
+        for (int x = begin; x < end; ++x) {
+            sums[x - begin] = addChannels(sums[x - begin], unpackPixel(in[x]));
+        }
+    }
+    for (int y = 0; y < height; ++y) {
+        const quint32* added = source.line(qMin(y + radius + 1, height - 1));
+        const quint32* removed = source.line(qMax(y - radius, 0));
+        quint32* out = target.line(y);
+        for (int x = begin; x < end; ++x) {
+            Channels& sum = sums[x - begin];
+            out[x] = packPixel(sum, scale);
+            sum = addChannels(sum, unpackPixel(added[x]));
+            sum = subtractChannels(sum, unpackPixel(removed[x]));
+        }
+    }
+}
+
+// Radius of the box blurs approximating a gaussian blur of deviation `sigma`
+QVector<int> boxBlurRadii(qreal sigma)
+{
+    const int n = BLUR_PASSES;
+    int lower = static_cast<int>(std::sqrt(12 * sigma * sigma / n + 1));
+    if (lower % 2 == 0) {
+        --lower;
+    }
+    const int upper = lower + 2;
+    const int lowerCount = qRound(
+      (12 * sigma * sigma - n * lower * lower - 4 * n * lower - 3 * n) /
+      (-4 * lower - 4));
+    QVector<int> radii;
+    for (int i = 0; i < n; ++i) {
+        radii.append(((i < lowerCount ? lower : upper) - 1) / 2);
+    }
+    return radii;
+}
+
+// Luma of the pixels [left - 1, left + width] of row `y`, the pixels outside
+// of the image repeat the edge pixels
+void lumaRow(const QImage& image, int y, int left, int width, qint16* luma)
+{
+    const auto* pixels = reinterpret_cast<const QRgb*>(
+      image.constScanLine(qBound(0, y, image.height() - 1)));
+    const int last = image.width() - 1;
+    for (int i = 0; i < width + 2; ++i) {
+        const QRgb pixel = pixels[qBound(0, left - 1 + i, last)];
+        luma[i] = static_cast<qint16>(
+          (qRed(pixel) * 77 + qGreen(pixel) * 150 + qBlue(pixel) * 29) >> 8);
+    }
+}
+
+// Sobel derivatives of a row from the luma of the rows above, at and below
+// it, their magnitudes are scaled down to 0-255
+void sobelRow(const qint16* above,
+              const qint16* row,
+              const qint16* below,
+              int width,
+              uchar* horizontal,
+              uchar* vertical)
+{
+    int x = 0;
+#ifdef USE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const auto load = [](const qint16* luma) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(luma));
+    };
+    for (; x + 8 <= width; x += 8) {
+        const __m128i a0 = load(above + x), a1 = load(above + x + 1),
+                      a2 = load(above + x + 2);
+        const __m128i b0 = load(row + x), b2 = load(row + x + 2);
+        const __m128i c0 = load(below + x), c1 = load(below + x + 1),
+                      c2 = load(below + x + 2);
+        const __m128i gx = _mm_sub_epi16(
+          _mm_add_epi16(_mm_add_epi16(a2, c2), _mm_add_epi16(b2, b2)),
+          _mm_add_epi16(_mm_add_epi16(a0, c0), _mm_add_epi16(b0, b0)));
+        const __m128i gy = _mm_sub_epi16(
+          _mm_add_epi16(_mm_add_epi16(c0, c2), _mm_add_epi16(c1, c1)),
+          _mm_add_epi16(_mm_add_epi16(a0, a2), _mm_add_epi16(a1, a1)));
+        // |g| / 4, at most 4 * 255 / 4
+        const __m128i magnitudeX =
+          _mm_srai_epi16(_mm_max_epi16(gx, _mm_sub_epi16(zero, gx)), 2);
+        const __m128i magnitudeY =
+          _mm_srai_epi16(_mm_max_epi16(gy, _mm_sub_epi16(zero, gy)), 2);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(horizontal + x),
+                         _mm_packus_epi16(magnitudeX, zero));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(vertical + x),
+                         _mm_packus_epi16(magnitudeY, zero));
+    }
+#endif
+    for (; x < width; ++x) {
+        const int gx = above[x + 2] + 2 * row[x + 2] + below[x + 2] -
+                       above[x] - 2 * row[x] - below[x];
+        const int gy = below[x] + 2 * below[x + 1] + below[x + 2] - above[x] -
+                       2 * above[x + 1] - above[x + 2];
+        horizontal[x] = static_cast<uchar>(std::abs(gx) >> 2);
+        vertical[x] = static_cast<uchar>(std::abs(gy) >> 2);
+    }
+}
+
+} // namespace
+
+void ImageFilters::sobel(const QImage& image,
+                         const QRect& area,
+                         QByteArray& horizontal,
+                         QByteArray& vertical)
+{
+    QImage source = image;
+    if (source.format() != QImage::Format_RGB32 &&
+        source.format() != QImage::Format_ARGB32 &&
+        source.format() != QImage::Format_ARGB32_Premultiplied) {
+        source = source.convertToFormat(QImage::Format_RGB32);
+    }
+    const int width = area.width();
+    horizontal.resize(width * area.height());
+    vertical.resize(width * area.height());
+    // The luma of three consecutive rows, used in turn
+    std::vector<qint16> rows[3];
+    for (std::vector<qint16>& row : rows) {
+        row.resize(width + 2);
+    }
+    lumaRow(source, area.top() - 1, area.left(), width, rows[0].data());
+    lumaRow(source, area.top(), area.left(), width, rows[1].data());
+    for (int y = 0; y < area.height(); ++y) {
+        lumaRow(source,
+                area.top() + y + 1,
+                area.left(),
+                width,
+                rows[(y + 2) % 3].data());
+        sobelRow(rows[y % 3].data(),
+                 rows[(y + 1) % 3].data(),
+                 rows[(y + 2) % 3].data(),
+                 width,
+                 reinterpret_cast<uchar*>(horizontal.data()) + y * width,
+                 reinterpret_cast<uchar*>(vertical.data()) + y * width);
+    }
+}
+
+void ImageFilters::pixelate(QImage& image, int blockSize)
+{
+    if (image.isNull() || blockSize <= 1) {
+        return;
+    }
+    prepare(image);
+    const int width = image.width();
+    const int height = image.height();
+    const int columns = (width + blockSize - 1) / blockSize;
+    QVector<quint32> sums(columns * 4);
+    QVector<quint32> averages(columns);
+
+    for (int top = 0; top < height; top += blockSize) {
+        const int rows = qMin(blockSize, height - top);
+        sums.fill(0);
+        for (int y = top; y < top + rows; ++y) {
+            const auto* line =
+              reinterpret_cast<const quint32*>(image.constScanLine(y));
+            for (int column = 0; column < columns; ++column) {
+                const int x = column * blockSize;
+                sumPixels(line + x,
+                          qMin(blockSize, width - x),
+                          sums.data() + column * 4);
+            }
+        }
+
+        for (int column = 0; column < columns; ++column) {
+            const quint32 pixels =
+              qMin(blockSize, width - column * blockSize) * rows;
+            quint32 average = 0;
+            for (int c = 0; c < 4; ++c) {
+                const quint32 sum = sums.at(column * 4 + c);
+                average |= ((sum + pixels / 2) / pixels) << (8 * c);
+            }
+            averages[column] = average;
+        }
+        for (int y = top; y < top + rows; ++y) {
+            auto* line = reinterpret_cast<quint32*>(image.scanLine(y));
+            for (int column = 0; column < columns; ++column) {
+                const int x = column * blockSize;
+                std::fill_n(
+                  line + x, qMin(blockSize, width - x), averages.at(column));
+            }
+        }
+    }
+}
+
+void ImageFilters::blur(QImage& image, qreal sigma)
+{
+    if (image.isNull() || sigma <= 0) {
+        return;
+    }
+    prepare(image);
+    const int width = image.width();
+    const int height = image.height();
+    QImage buffer(image.size(), image.format());
+    const Pixels pixels{ image.bits(), image.bytesPerLine() };
+    const Pixels temporary{ buffer.bits(), buffer.bytesPerLine() };
+
+    for (int radius : boxBlurRadii(sigma)) {
+        if (radius <= 0) {
+            continue;
+        }
+        forEachStrip(height, MIN_STRIP_SIZE, [&](int begin, int end) {
+            boxBlurRows(pixels, temporary, width, radius, begin, end);
+        });
+        forEachStrip(width, MIN_STRIP_SIZE, [&](int begin, int end) {
+            boxBlurColumns(temporary, pixels, height, radius, begin, end);
+        });
+    }
+}
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QImage>
+
+// Filters working in place on the scanlines of premultiplied ARGB32 images,
+// other formats are converted first.
+namespace ImageFilters {
+
+// Replace every `blockSize` x `blockSize` block (aligned on the top-left
+// corner of the image) by the average of its pixels
+void pixelate(QImage& image, int blockSize);
+
+// Gaussian blur of standard deviation `sigma` (pixels) approximated by three
+// box blurs, the rows and columns are split into strips processed by the
+// global thread pool. Pixels outside of the image repeat the edge pixels.
+void blur(QImage& image, qreal sigma);
+
+// Sobel gradient of the pixels `area` of `image`, which is only read: for
+// each pixel row by row, `horizontal` receives the magnitude of the x
+// derivative (high on vertical edges) and `vertical` the one of the y
+// derivative, both scaled down to 0-255. Pixels outside of the image repeat
+// the edge pixels.
+void sobel(const QImage& image,
+           const QRect& area,
+           QByteArray& horizontal,
+           QByteArray& vertical);
+
+} // namespace
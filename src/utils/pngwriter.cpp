@@ -0,0 +1,338 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "pngwriter.h"
+
+#if defined(USE_ZLIB)
+#include "src/utils/strips.h"
+#include <QThreadPool>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <zlib.h>
+#else
+#include <QBuffer>
+#include <QImageWriter>
+#endif
+
+// Minimum number of rows deflated by a thread
+#define MIN_STRIP_ROWS 64
+// Size of the deflate window, the end of a strip primes the next one
+#define WINDOW_SIZE 32768
+
+#if defined(USE_ZLIB)
+
+namespace {
+
+// A strip of rows filtered and deflated
+struct Strip
+{
+    QByteArray deflated;
+    uLong adler = 1;
+    int length = 0;
+    bool ok = false;
+};
+
+void appendUInt32(QByteArray& data, quint32 value)
+{
+    const char bytes[4] = { static_cast<char>(value >> 24),
+                            static_cast<char>(value >> 16),
+                            static_cast<char>(value >> 8),
+                            static_cast<char>(value) };
+    data.append(bytes, 4);
+}
+
+void appendChunk(QByteArray& png, const char* type, const QByteArray& data)
+{
+    appendUInt32(png, static_cast<quint32>(data.size()));
+    const int start = png.size();
+    png.append(type, 4);
+    png.append(data);
+    // The CRC covers the type and the data
+    appendUInt32(
+      png,
+      crc32(0L,
+            reinterpret_cast<const Bytef*>(png.constData() + start),
+            static_cast<uInt>(data.size() + 4)));
+}
+
+// Pixels of row `y` as the bytes of a PNG row, RGB or RGBA
+void packRow(const QImage& image, int y, bool alpha, uchar* out)
+{
+    const auto* pixels = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+    const bool premultiplied =
+      image.format() == QImage::Format_ARGB32_Premultiplied;
+    for (int x = 0; x < image.width(); ++x) {
+        const QRgb pixel =
+          premultiplied ? qUnpremultiply(pixels[x]) : pixels[x];
+        *out++ = static_cast<uchar>(qRed(pixel));
+        *out++ = static_cast<uchar>(qGreen(pixel));
+        *out++ = static_cast<uchar>(qBlue(pixel));
+        if (alpha) {
+            *out++ = static_cast<uchar>(qAlpha(pixel));
+        }
+    }
+}
+
+uchar paeth(int a, int b, int c)
+{
+    const int p = a + b - c;
+    const int pa = std::abs(p - a);
+    const int pb = std::abs(p - b);
+    const int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return static_cast<uchar>(a);
+    }
+    return static_cast<uchar>(pb <= pc ? b : c);
+}
+
+// Filter `row` against `previous` into `out`, which starts with the filter
+// type. All the filters are tried and the one whose bytes have the lowest
+// sum of absolute values is kept, the heuristic of libpng. `scratch` holds
+// 5 rows.
+void filterRow(const uchar* row,
+               const uchar* previous,
+               int length,
+               int bpp,
+               bool filter,
+               uchar* scratch,
+               uchar* out)
+{
+    if (!filter) {
+        out[0] = 0;
+        std::memcpy(out + 1, row, length);
+        return;
+    }
+    uchar* candidates[5];
+    long scores[5] = { 0, 0, 0, 0, 0 };
+    for (int type = 0; type < 5; ++type) {
+        candidates[type] = scratch + type * length;
+    }
+    for (int i = 0; i < length; ++i) {
+        const int a = i >= bpp ? row[i - bpp] : 0;
+        const int b = previous[i];
+        const int c = i >= bpp ? previous[i - bpp] : 0;
+        const uchar values[5] = {
+            row[i],
+            static_cast<uchar>(row[i] - a),
+            static_cast<uchar>(row[i] - b),
+            static_cast<uchar>(row[i] - (a + b) / 2),
+            static_cast<uchar>(row[i] - paeth(a, b, c)),
+        };
+        for (int type = 0; type < 5; ++type) {
+            candidates[type][i] = values[type];
+            scores[type] += std::abs(static_cast<signed char>(values[type]));
+        }
+    }
+    int best = 0;
+    for (int type = 1; type < 5; ++type) {
+        if (scores[type] < scores[best]) {
+            best = type;
+        }
+    }
+    out[0] = static_cast<uchar>(best);
+    std::memcpy(out + 1, candidates[best], length);
+}
+
+// Filtered rows [begin, end) of the image, every row prefixed by its filter
+QByteArray filterRows(const QImage& image,
+                      bool alpha,
+                      bool filter,
+                      int begin,
+                      int end)
+{
+    const int length = image.width() * (alpha ? 4 : 3);
+    std::vector<uchar> previous(length, 0);
+    std::vector<uchar> current(length);
+    std::vector<uchar> scratch(filter ? 5 * length : 0);
+    if (begin > 0) {
+        packRow(image, begin - 1, alpha, previous.data());
+    }
+    QByteArray filtered((end - begin) * (length + 1), Qt::Uninitialized);
+    auto* out = reinterpret_cast<uchar*>(filtered.data());
+    for (int y = begin; y < end; ++y) {
+        packRow(image, y, alpha, current.data());
+        filterRow(current.data(),
+                  previous.data(),
+                  length,
+                  alpha ? 4 : 3,
+                  filter,
+                  scratch.data(),
+                  out + (y - begin) * (length + 1));
+        std::swap(previous, current);
+    }
+    return filtered;
+}
+
+// Raw deflate of `input` primed with `dictionary`. A strip that is not the
+// last one ends with a sync flush, on a byte boundary without a final block.
+bool deflateStrip(const QByteArray& input,
+                  const QByteArray& dictionary,
+                  int level,
+                  bool last,
+                  QByteArray& out)
+{
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(
+          &stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) !=
+        Z_OK) {
+        return false;
+    }
+    if (!dictionary.isEmpty()) {
+        deflateSetDictionary(
+          &stream,
+          reinterpret_cast<const Bytef*>(dictionary.constData()),
+          static_cast<uInt>(dictionary.size()));
+    }
+    out.resize(static_cast<int>(deflateBound(&stream, input.size())) + 16);
+    stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(input.constData()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+
+    const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    int result = Z_OK;
+    forever {
+        result = deflate(&stream, flush);
+        if ((result != Z_OK && result != Z_BUF_ERROR) ||
+            stream.avail_out != 0) {
+            break;
+        }
+        // Out of space, which the bound should prevent
+        const int used = static_cast<int>(stream.total_out);
+        out.resize(out.size() * 2);
+        stream.next_out = reinterpret_cast<Bytef*>(out.data()) + used;
+        stream.avail_out = static_cast<uInt>(out.size() - used);
+    }
+    out.resize(static_cast<int>(stream.total_out));
+    deflateEnd(&stream);
+    return last ? result == Z_STREAM_END
+                : result == Z_OK && stream.avail_in == 0;
+}
+
+void encodeStrip(const QImage& image,
+                 bool alpha,
+                 int level,
+                 int begin,
+                 int end,
+                 bool last,
+                 Strip& strip)
+{
+    // Filtering doesn't help storing
+    const bool filter = level > 0;
+    const QByteArray filtered = filterRows(image, alpha, filter, begin, end);
+    QByteArray dictionary;
+    if (begin > 0 && level > 0) {
+        // The end of the previous strip, filtered again here
+        const int rowLength = image.width() * (alpha ? 4 : 3) + 1;
+        const int rows = (WINDOW_SIZE + rowLength - 1) / rowLength;
+        dictionary =
+          filterRows(image, alpha, filter, qMax(0, begin - rows), begin)
+            .right(WINDOW_SIZE);
+    }
+    strip.length = filtered.size();
+    strip.adler = adler32(1L,
+                          reinterpret_cast<const Bytef*>(filtered.constData()),
+                          static_cast<uInt>(filtered.size()));
+    strip.ok = deflateStrip(filtered, dictionary, level, last, strip.deflated);
+}
+
+// The zlib header of a stream compressed at `level`
+QByteArray zlibHeader(int level)
+{
+    const int cmf = 0x78;
+    const int flevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+    int flg = flevel << 6;
+    flg |= (31 - (cmf * 256 + flg) % 31) % 31;
+    QByteArray header;
+    header.append(static_cast<char>(cmf));
+    header.append(static_cast<char>(flg));
+    return header;
+}
+
+} // namespace
+
+#endif
+
+QByteArray PngWriter::encode(const QImage& source, int level)
+{
+    if (source.isNull()) {
+        return QByteArray();
+    }
+    level = qBound(0, level, 9);
+#if defined(USE_ZLIB)
+    QImage image = source;
+    if (image.format() != QImage::Format_RGB32 &&
+        image.format() != QImage::Format_ARGB32 &&
+        image.format() != QImage::Format_ARGB32_Premultiplied) {
+        image = image.convertToFormat(image.hasAlphaChannel()
+                                        ? QImage::Format_ARGB32
+                                        : QImage::Format_RGB32);
+    }
+    const bool alpha = image.hasAlphaChannel();
+    const int height = image.height();
+
+    // One strip per thread, of at least MIN_STRIP_ROWS rows
+    const int threads = QThreadPool::globalInstance()->maxThreadCount();
+    const int count = qBound(1, height / MIN_STRIP_ROWS, qMax(1, threads));
+    std::vector<Strip> strips(count);
+    forEachStrip(count, 1, [&](int first, int last) {
+        for (int i = first; i < last; ++i) {
+            encodeStrip(image,
+                        alpha,
+                        level,
+                        i * height / count,
+                        (i + 1) * height / count,
+                        i == count - 1,
+                        strips[i]);
+        }
+    });
+
+    QByteArray idat = zlibHeader(level);
+    uLong adler = 1;
+    for (const Strip& strip : strips) {
+        if (!strip.ok) {
+            return QByteArray();
+        }
+        idat.append(strip.deflated);
+        adler = adler32_combine(adler, strip.adler, strip.length);
+    }
+    appendUInt32(idat, static_cast<quint32>(adler));
+
+    QByteArray header;
+    appendUInt32(header, static_cast<quint32>(image.width()));
+    appendUInt32(header, static_cast<quint32>(height));
+    // 8 bits per channel, RGBA or RGB, no interlacing
+    header.append(static_cast<char>(8));
+    header.append(static_cast<char>(alpha ? 6 : 2));
+    header.append(3, '\0');
+
+    QByteArray png("\x89PNG\r\n\x1a\n", 8);
+    appendChunk(png, "IHDR", header);
+    if (image.dotsPerMeterX() > 0 && image.dotsPerMeterY() > 0) {
+        QByteArray density;
+        appendUInt32(density, static_cast<quint32>(image.dotsPerMeterX()));
+        appendUInt32(density, static_cast<quint32>(image.dotsPerMeterY()));
+        // The unit is the meter
+        density.append(static_cast<char>(1));
+        appendChunk(png, "pHYs", density);
+    }
+    appendChunk(png, "IDAT", idat);
+    appendChunk(png, "IEND", QByteArray());
+    return png;
+#else
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    QImageWriter writer(&buffer, "png");
+    // QImageWriter turns the quality into the level (100 - quality) * 9 / 91
+    writer.setQuality(100 - (level * 91 + 8) / 9);
+    if (!writer.write(source)) {
+        return QByteArray();
+    }
+    return data;
+#endif
+}
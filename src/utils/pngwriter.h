@@ -0,0 +1,23 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QByteArray>
+#include <QImage>
+
+// PNG encoding spread over the threads of the global pool, for the large
+// captures whose single threaded encoding dominates the time of an export.
+namespace PngWriter {
+
+// Encode `image` as a PNG file with the zlib compression `level` (0-9).
+//
+// The image is split into horizontal strips which are filtered and deflated
+// on separate threads. Each strip is a run of deflate blocks ending on a
+// byte boundary, primed with the end of the previous strip, so the strips
+// are concatenated into a single valid IDAT stream. Without zlib the image
+// is written by QImageWriter with the matching quality. Returns an empty
+// array on failure.
+QByteArray encode(const QImage& image, int level);
+
+} // namespace PngWriter
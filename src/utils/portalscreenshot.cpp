@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "portalscreenshot.h"
+#include <QCoreApplication>
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusInterface>
+#include <QDBusObjectPath>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImageReader>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+#include <QUuid>
+
+// The portal may ask the user for the permission first
+#define PORTAL_TIMEOUT 120000
+
+#define PORTAL_SERVICE "org.freedesktop.portal.Desktop"
+#define PORTAL_PATH "/org/freedesktop/portal/desktop"
+#define PORTAL_INTERFACE "org.freedesktop.portal.Screenshot"
+
+struct PortalScreenshot::Pending
+{
+    quint64 id = 0;
+    QRect region;
+    QElapsedTimer timer;
+    Timings timings;
+};
+
+PortalScreenshot::PortalScreenshot()
+  : m_interface(nullptr)
+  , m_nextId(1)
+{
+    qRegisterMetaType<PortalScreenshot::Result>();
+}
+
+PortalScreenshot* PortalScreenshot::instance()
+{
+    static PortalScreenshot* portal = []() {
+        auto* thread = new QThread();
+        thread->setObjectName(QStringLiteral("PortalScreenshot"));
+        auto* instance = new PortalScreenshot();
+        instance->moveToThread(thread);
+        QObject::connect(
+          thread, &QThread::finished, instance, &QObject::deleteLater);
+        QObject::connect(
+          qApp, &QCoreApplication::aboutToQuit, thread, [thread]() {
+              thread->quit();
+              thread->wait();
+          });
+        thread->start();
+        return instance;
+    }();
+    return portal;
+}
+
+void PortalScreenshot::grabAsync(
+  const QRect& region,
+  QObject* context,
+  const std::function<void(const Result&)>& callback)
+{
+    auto pending = QSharedPointer<Pending>::create();
+    pending->id = m_nextId.fetchAndAddRelaxed(1);
+    pending->region = region;
+    pending->timer.start();
+
+    // Queued to the thread of `context`, and dropped with it
+    auto connection = QSharedPointer<QMetaObject::Connection>::create();
+    *connection = connect(
+      this,
+      &PortalScreenshot::grabbed,
+      context,
+      [id = pending->id, connection, callback](quint64 done,
+                                               const Result& result) {
+          if (done != id) {
+              return;
+          }
+          QObject::disconnect(*connection);
+          callback(result);
+      });
+    QMetaObject::invokeMethod(
+      this, [this, pending]() { request(pending); }, Qt::QueuedConnection);
+}
+
+void PortalScreenshot::request(const QSharedPointer<Pending>& pending)
+{
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    if (m_interface == nullptr) {
+        m_interface = new QDBusInterface(QStringLiteral(PORTAL_SERVICE),
+                                         QStringLiteral(PORTAL_PATH),
+                                         QStringLiteral(PORTAL_INTERFACE),
+                                         bus,
+                                         this);
+        // A single subscription for the responses of all the requests
+        bus.connect(QStringLiteral(PORTAL_SERVICE),
+                    QString(),
+                    QStringLiteral("org.freedesktop.portal.Request"),
+                    QStringLiteral("Response"),
+                    this,
+                    SLOT(handleResponse(QDBusMessage)));
+    }
+
+    // The handle of the request is known in advance, the response can't be
+    // missed
+    const QString token =
+      QUuid::createUuid().toString().remove('-').remove('{').remove('}');
+    const QString handle =
+      QStringLiteral(PORTAL_PATH "/request/") +
+      bus.baseService().remove(':').replace('.', '_') + '/' + token;
+    m_pending.insert(handle, pending);
+    QTimer::singleShot(PORTAL_TIMEOUT, this, [this, id = pending->id]() {
+        // The handle may have been remapped since
+        for (auto it = m_pending.constBegin(); it != m_pending.constEnd();
+             ++it) {
+            if (it.value()->id == id) {
+                finish(it.key(),
+                       QImage(),
+                       tr("The screenshot portal didn't answer"));
+                return;
+            }
+        }
+    });
+
+    QDBusPendingCall call = m_interface->asyncCall(
+      QStringLiteral("Screenshot"),
+      QString(),
+      QVariantMap({ { QStringLiteral("handle_token"), token },
+                    { QStringLiteral("interactive"), false } }));
+    auto* watcher = new QDBusPendingCallWatcher(call, this);
+    connect(watcher,
+            &QDBusPendingCallWatcher::finished,
+            this,
+            [this, handle](QDBusPendingCallWatcher* watcher) {
+                requestStarted(watcher, handle);
+            });
+}
+
+void PortalScreenshot::requestStarted(QDBusPendingCallWatcher* watcher,
+                                      const QString& handle)
+{
+    watcher->deleteLater();
+    QDBusPendingReply<QDBusObjectPath> reply = *watcher;
+    if (reply.isError()) {
+        finish(handle, QImage(), reply.error().message());
+        return;
+    }
+    // Portals older than 0.9 don't use the predicted handle
+    const QString path = reply.value().path();
+    if (path != handle && m_pending.contains(handle)) {
+        m_pending.insert(path, m_pending.take(handle));
+    }
+}
+
+void PortalScreenshot::handleResponse(const QDBusMessage& message)
+{
+    const QString handle = message.path();
+    const QSharedPointer<Pending> pending = m_pending.value(handle);
+    const QList<QVariant> arguments = message.arguments();
+    if (pending.isNull() || arguments.size() < 2) {
+        return;
+    }
+    pending->timings.portal = pending->timer.elapsed();
+    if (arguments.at(0).toUInt() != 0) {
+        finish(handle, QImage(), tr("The screenshot was cancelled"));
+        return;
+    }
+
+    const QVariantMap results =
+      qdbus_cast<QVariantMap>(arguments.at(1).value<QDBusArgument>());
+    // Parse this as URI to handle unicode properly
+    const QString path =
+      QUrl(results.value(QStringLiteral("uri")).toString()).toLocalFile();
+    // Decode from the file, only the region when the format allows it
+    QElapsedTimer decodeTimer;
+    decodeTimer.start();
+    QImageReader reader(path);
+    if (!pending->region.isNull()) {
+        reader.setClipRect(pending->region);
+    }
+    const QImage image = reader.read();
+    pending->timings.decode = decodeTimer.elapsed();
+    QFile::remove(path);
+    finish(handle, image, image.isNull() ? reader.errorString() : QString());
+}
+
+void PortalScreenshot::finish(const QString& handle,
+                              const QImage& image,
+                              const QString& error)
+{
+    const QSharedPointer<Pending> pending = m_pending.take(handle);
+    if (pending.isNull()) {
+        return;
+    }
+    Result result;
+    result.image = image;
+    result.error = error;
+    result.timings = pending->timings;
+    result.timings.total = pending->timer.elapsed();
+    emit grabbed(pending->id, result);
+}
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QAtomicInteger>
+#include <QDBusMessage>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QRect>
+#include <QSharedPointer>
+#include <functional>
+
+class QDBusInterface;
+class QDBusPendingCallWatcher;
+
+/**
+ * @brief Non-interactive screenshots through xdg-desktop-portal.
+ *
+ * A single instance lives in its own thread for the whole life of the
+ * process (the daemon keeps it between captures): the portal interface and
+ * the subscription to the responses are only set up once. The file written
+ * by the portal is decoded in that thread as well, straight from the disk.
+ *
+ * `grabAsync` returns right away and calls back in the thread of the caller,
+ * there is no blocking variant: the portal may ask the user for the
+ * permission first, which can take as long as the user wants.
+ */
+class PortalScreenshot : public QObject
+{
+    Q_OBJECT
+public:
+    // Time spent in each stage of the last capture, in milliseconds
+    struct Timings
+    {
+        // From the call to the response of the portal
+        qint64 portal = -1;
+        // Reading and decoding the file
+        qint64 decode = -1;
+        // Everything, as seen by the caller
+        qint64 total = -1;
+    };
+
+    struct Result
+    {
+        // Null on failure
+        QImage image;
+        QString error;
+        Timings timings;
+    };
+
+    static PortalScreenshot* instance();
+
+    // Capture the desktop and decode the pixels `region` of it (everything
+    // when null), then call `callback` in the thread of `context`. It is not
+    // called when `context` is destroyed in the meantime.
+    void grabAsync(const QRect& region,
+                   QObject* context,
+                   const std::function<void(const Result&)>& callback);
+
+signals:
+    // Emitted in the portal thread when the request `id` is finished
+    void grabbed(quint64 id, const PortalScreenshot::Result& result);
+
+private slots:
+    void handleResponse(const QDBusMessage& message);
+
+private:
+    struct Pending;
+
+    PortalScreenshot();
+
+    void request(const QSharedPointer<Pending>& pending);
+    void requestStarted(QDBusPendingCallWatcher* watcher,
+                        const QString& handle);
+    void finish(const QString& handle,
+                const QImage& image,
+                const QString& error);
+
+    // class members
+    QDBusInterface* m_interface;
+    QHash<QString, QSharedPointer<Pending>> m_pending;
+    QAtomicInteger<quint64> m_nextId;
+};
+
+Q_DECLARE_METATYPE(PortalScreenshot::Result)
@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "ppmstreamreader.h"
+#include <QObject>
+#include <cctype>
+#include <climits>
+
+// A valid header never gets this long, even with comments
+#define MAX_HEADER_SIZE 4096
+
+PpmStreamReader::PpmStreamReader()
+  : m_row(0)
+{}
+
+bool PpmStreamReader::feed(const QByteArray& data)
+{
+    if (hasError()) {
+        return false;
+    }
+    if (m_image.isNull()) {
+        m_header.append(data);
+        if (!readHeader()) {
+            return !hasError();
+        }
+        // m_header now holds the first pixels
+        readRows(m_header.constData(), m_header.size());
+        m_header.clear();
+    } else {
+        readRows(data.constData(), data.size());
+    }
+    return true;
+}
+
+bool PpmStreamReader::isComplete() const
+{
+    return !m_image.isNull() && m_row == m_image.height();
+}
+
+bool PpmStreamReader::hasError() const
+{
+    return !m_error.isEmpty();
+}
+
+QString PpmStreamReader::errorString() const
+{
+    return m_error;
+}
+
+QImage PpmStreamReader::image() const
+{
+    return isComplete() ? m_image : QImage();
+}
+
+// Parse "P6 <width> <height> <maxval>" followed by a single whitespace,
+// comments start with '#' and end at the end of the line
+bool PpmStreamReader::readHeader()
+{
+    const char* data = m_header.constData();
+    const int size = m_header.size();
+    int values[3] = { 0, 0, 0 };
+    int pos = 0;
+    for (int field = 0; field < 4; ++field) {
+        // Whitespace and comments before each field
+        while (pos < size) {
+            if (data[pos] == '#') {
+                while (pos < size && data[pos] != '\n') {
+                    ++pos;
+                }
+            } else if (isspace(static_cast<uchar>(data[pos]))) {
+                ++pos;
+            } else {
+                break;
+            }
+        }
+        if (field == 0) {
+            if (size - pos < 2) {
+                break;
+            }
+            if (data[pos] != 'P' || data[pos + 1] != '6') {
+                setError(QObject::tr("Not a binary PPM image"));
+                return false;
+            }
+            pos += 2;
+            continue;
+        }
+        const int start = pos;
+        qint64 value = 0;
+        while (pos < size && isdigit(static_cast<uchar>(data[pos])) &&
+               value <= INT_MAX) {
+            value = value * 10 + (data[pos] - '0');
+            ++pos;
+        }
+        if (pos == size) {
+            // The number may continue in the next chunk
+            break;
+        }
+        if (pos == start || value > INT_MAX ||
+            !isspace(static_cast<uchar>(data[pos]))) {
+            setError(QObject::tr("Malformed PPM header"));
+            return false;
+        }
+        values[field - 1] = static_cast<int>(value);
+        if (field == 3) {
+            // Exactly one whitespace before the pixels
+            ++pos;
+            if (values[0] <= 0 || values[1] <= 0 || values[2] != 255) {
+                setError(QObject::tr("Unsupported PPM image"));
+                return false;
+            }
+            m_image = QImage(values[0], values[1], QImage::Format_RGB32);
+            if (m_image.isNull()) {
+                setError(QObject::tr("PPM image too large"));
+                return false;
+            }
+            m_header.remove(0, pos);
+            return true;
+        }
+    }
+    if (size > MAX_HEADER_SIZE) {
+        setError(QObject::tr("Malformed PPM header"));
+    }
+    return false;
+}
+
+void PpmStreamReader::readRows(const char* data, int size)
+{
+    const int width = m_image.width();
+    const int rowSize = width * 3;
+    const auto convertRow = [&](const char* row) {
+        const auto* rgb = reinterpret_cast<const uchar*>(row);
+        auto* line = reinterpret_cast<QRgb*>(m_image.scanLine(m_row));
+        for (int x = 0; x < width; ++x, rgb += 3) {
+            line[x] = qRgb(rgb[0], rgb[1], rgb[2]);
+        }
+        ++m_row;
+    };
+
+    if (!m_partialRow.isEmpty()) {
+        const int missing = qMin(rowSize - m_partialRow.size(), size);
+        m_partialRow.append(data, missing);
+        data += missing;
+        size -= missing;
+        if (m_partialRow.size() < rowSize) {
+            return;
+        }
+        if (m_row < m_image.height()) {
+            convertRow(m_partialRow.constData());
+        }
+        m_partialRow.clear();
+    }
+    for (; size >= rowSize && m_row < m_image.height(); size -= rowSize) {
+        convertRow(data);
+        data += rowSize;
+    }
+    if (m_row < m_image.height() && size > 0) {
+        m_partialRow.append(data, size);
+    }
+}
+
+void PpmStreamReader::setError(const QString& error)
+{
+    m_error = error;
+    m_image = QImage();
+}
@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+
+/**
+ * @brief Decodes a binary PPM (P6, 8 bits per channel) fed in chunks.
+ *
+ * Rows are converted into the image as soon as they are received, so a PPM
+ * read from a pipe (e.g. `grim -t ppm -`) is decoded while the producer is
+ * still writing it.
+ */
+class PpmStreamReader
+{
+public:
+    PpmStreamReader();
+
+    // Decode the next chunk, returns false on a malformed stream
+    bool feed(const QByteArray& data);
+    bool isComplete() const;
+    bool hasError() const;
+    QString errorString() const;
+    QImage image() const;
+
+private:
+    bool readHeader();
+    void readRows(const char* data, int size);
+    void setError(const QString& error);
+
+    // class members
+    QByteArray m_header;
+    QByteArray m_partialRow;
+    QImage m_image;
+    int m_row;
+    QString m_error;
+};
@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "qoiwriter.h"
+
+// Operations of the format, see https://qoiformat.org/qoi-specification.pdf
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xc0
+#define QOI_OP_RGB 0xfe
+#define QOI_OP_RGBA 0xff
+// Longest run of an operation
+#define MAX_RUN 62
+
+namespace {
+
+void appendUInt32(QByteArray& data, quint32 value)
+{
+    const char bytes[4] = { static_cast<char>(value >> 24),
+                            static_cast<char>(value >> 16),
+                            static_cast<char>(value >> 8),
+                            static_cast<char>(value) };
+    data.append(bytes, 4);
+}
+
+int hash(QRgb pixel)
+{
+    return (qRed(pixel) * 3 + qGreen(pixel) * 5 + qBlue(pixel) * 7 +
+            qAlpha(pixel) * 11) %
+           64;
+}
+
+} // namespace
+
+QByteArray QoiWriter::encode(const QImage& source)
+{
+    if (source.isNull()) {
+        return QByteArray();
+    }
+    QImage image = source;
+    if (image.format() != QImage::Format_RGB32 &&
+        image.format() != QImage::Format_ARGB32) {
+        image = image.convertToFormat(image.hasAlphaChannel()
+                                        ? QImage::Format_ARGB32
+                                        : QImage::Format_RGB32);
+    }
+    const bool alpha = image.hasAlphaChannel();
+    const int width = image.width();
+    const int height = image.height();
+
+    QByteArray qoi("qoif", 4);
+    appendUInt32(qoi, static_cast<quint32>(width));
+    appendUInt32(qoi, static_cast<quint32>(height));
+    qoi.append(static_cast<char>(alpha ? 4 : 3));
+    // sRGB with linear alpha
+    qoi.append('\0');
+
+    // The worst case is an RGBA operation per pixel, plus the end marker
+    const int header = qoi.size();
+    qoi.resize(header + width * height * (alpha ? 5 : 4) + 8);
+    auto* out = reinterpret_cast<uchar*>(qoi.data()) + header;
+    uchar* const start = out;
+
+    QRgb index[64] = {};
+    QRgb previous = qRgba(0, 0, 0, 255);
+    int run = 0;
+    for (int y = 0; y < height; ++y) {
+        const auto* pixels =
+          reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        for (int x = 0; x < width; ++x) {
+            // RGB32 has an undefined alpha byte
+            const QRgb pixel = alpha ? pixels[x] : pixels[x] | 0xff000000;
+            if (pixel == previous) {
+                if (++run == MAX_RUN) {
+                    *out++ = QOI_OP_RUN | (run - 1);
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                *out++ = QOI_OP_RUN | (run - 1);
+                run = 0;
+            }
+            const int slot = hash(pixel);
+            if (index[slot] == pixel) {
+                *out++ = QOI_OP_INDEX | slot;
+            } else if (qAlpha(pixel) == qAlpha(previous)) {
+                index[slot] = pixel;
+                const auto delta = [](int value, int from) {
+                    return static_cast<int>(
+                      static_cast<signed char>(value - from));
+                };
+                const int dr = delta(qRed(pixel), qRed(previous));
+                const int dg = delta(qGreen(pixel), qGreen(previous));
+                const int db = delta(qBlue(pixel), qBlue(previous));
+                const int drg = dr - dg;
+                const int dbg = db - dg;
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 &&
+                    db <= 1) {
+                    *out++ = QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 |
+                             (db + 2);
+                } else if (drg >= -8 && drg <= 7 && dg >= -32 && dg <= 31 &&
+                           dbg >= -8 && dbg <= 7) {
+                    *out++ = QOI_OP_LUMA | (dg + 32);
+                    *out++ = (drg + 8) << 4 | (dbg + 8);
+                } else {
+                    *out++ = QOI_OP_RGB;
+                    *out++ = qRed(pixel);
+                    *out++ = qGreen(pixel);
+                    *out++ = qBlue(pixel);
+                }
+            } else {
+                index[slot] = pixel;
+                *out++ = QOI_OP_RGBA;
+                *out++ = qRed(pixel);
+                *out++ = qGreen(pixel);
+                *out++ = qBlue(pixel);
+                *out++ = qAlpha(pixel);
+            }
+            previous = pixel;
+        }
+    }
+    if (run > 0) {
+        *out++ = QOI_OP_RUN | (run - 1);
+    }
+    // End marker
+    for (int i = 0; i < 7; ++i) {
+        *out++ = 0;
+    }
+    *out++ = 1;
+    qoi.resize(header + static_cast<int>(out - start));
+    return qoi;
+}
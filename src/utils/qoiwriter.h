@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QByteArray>
+#include <QImage>
+
+// Encoding to the "Quite OK Image" format, lossless and many times faster to
+// write than PNG for files about as large as PNG at its fastest level.
+namespace QoiWriter {
+
+// Encode `image` as a QOI file, RGBA when it has an alpha channel and RGB
+// otherwise. Returns an empty array on failure.
+QByteArray encode(const QImage& image);
+
+} // namespace QoiWriter
@@ -14,99 +14,391 @@
 #include <QScreen>
 
 #if defined(Q_OS_LINUX) || defined(Q_OS_UNIX)
-#include "request.h"
-#include <QDBusInterface>
-#include <QDBusReply>
-#include <QDir>
-#include <QUrl>
-#include <QUuid>
+#include "src/utils/portalscreenshot.h"
+#include "src/utils/ppmstreamreader.h"
 #endif
 
+#ifdef USE_XCB_SHM
+#include "src/utils/xcbshmgrabber.h"
+#include <QAtomicInt>
+#include <QPainter>
+#include <QRegion>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <cstring>
+#endif
+
+namespace {
+
+#ifdef USE_XCB_SHM
+// Grab `source` (root window coordinates) and copy it to `target`
+class ScreenGrabTask : public QRunnable
+{
+public:
+    ScreenGrabTask(const QRect& source,
+                   uchar* target,
+                   int bytesPerLine,
+                   QSemaphore* done,
+                   QAtomicInt* failures)
+      : m_source(source)
+      , m_target(target)
+      , m_bytesPerLine(bytesPerLine)
+      , m_done(done)
+      , m_failures(failures)
+    {}
+
+    void run() override
+    {
+        const QImage image = XcbShmGrabber::instance()->grab(m_source);
+        if (image.isNull()) {
+            m_failures->ref();
+        } else {
+            const int lineSize = image.width() * 4;
+            for (int y = 0; y < image.height(); ++y) {
+                memcpy(m_target + static_cast<qptrdiff>(y) * m_bytesPerLine,
+                       image.constScanLine(y),
+                       lineSize);
+            }
+        }
+        m_done->release();
+    }
+
+private:
+    QRect m_source;
+    uchar* m_target;
+    int m_bytesPerLine;
+    QSemaphore* m_done;
+    QAtomicInt* m_failures;
+};
+
+// Grab every screen inside `desktop` (device pixels) on the global thread pool
+// and stitch them together. Only the screens are transferred, the gaps
+// between them are filled with black.
+QImage grabX11ShmScreens(const QRect& desktop)
+{
+    XcbShmGrabber* grabber = XcbShmGrabber::instance();
+    QVector<QRect> sources;
+    QRegion gaps(QRect(QPoint(0, 0), desktop.size()));
+    for (QScreen* const screen : QGuiApplication::screens()) {
+        const QRect geometry = screen->geometry();
+        // X11 screens keep their native top-left corner, only their size is
+        // scaled
+        const QSize size = geometry.size() * screen->devicePixelRatio();
+        const QRect source =
+          QRect(geometry.topLeft(), size).intersected(desktop);
+        // Mirrored screens are grabbed once
+        if (!source.isEmpty() && !sources.contains(source)) {
+            sources.append(source);
+            gaps -= source.translated(-desktop.topLeft());
+        }
+    }
+    if (sources.isEmpty()) {
+        return QImage();
+    }
+
+    QImage image(desktop.size(), grabber->format());
+    if (!gaps.isEmpty()) {
+        QPainter painter(&image);
+        for (const QRect& gap : gaps) {
+            painter.fillRect(gap, Qt::black);
+        }
+    }
+
+    // Every task writes its own part of the image
+    uchar* bits = image.bits();
+    const int bytesPerLine = image.bytesPerLine();
+    const auto target = [&](const QRect& source) {
+        const QPoint offset = source.topLeft() - desktop.topLeft();
+        return bits + static_cast<qptrdiff>(offset.y()) * bytesPerLine +
+               offset.x() * 4;
+    };
+    QThreadPool* pool = QThreadPool::globalInstance();
+    QSemaphore done;
+    QAtomicInt failures;
+    int started = 0;
+    for (int i = 1; i < sources.size(); ++i) {
+        auto* task = new ScreenGrabTask(
+          sources.at(i), target(sources.at(i)), bytesPerLine, &done, &failures);
+        if (pool->tryStart(task)) {
+            ++started;
+        } else {
+            task->run();
+            delete task;
+            done.acquire();
+        }
+    }
+    ScreenGrabTask(
+      sources.at(0), target(sources.at(0)), bytesPerLine, &done, &failures)
+      .run();
+    done.acquire(started + 1);
+    return failures.loadAcquire() == 0 ? image : QImage();
+}
+#endif
+
+// Grab `rect` (device pixels of the root window) through MIT-SHM when
+// possible. With `stitchScreens`, the screens are grabbed in parallel and the
+// gaps between them are skipped. Returns a null pixmap when the caller must
+// fall back to QScreen::grabWindow.
+QPixmap grabX11Shm(const QRect& rect, qreal ratio, bool stitchScreens)
+{
+#ifdef USE_XCB_SHM
+    if (QGuiApplication::platformName() != QLatin1String("xcb")) {
+        return QPixmap();
+    }
+    XcbShmGrabber* grabber = XcbShmGrabber::instance();
+    if (!grabber->isAvailable() ||
+        !QRect(QPoint(0, 0), grabber->rootSize()).contains(rect)) {
+        return QPixmap();
+    }
+    QImage image = stitchScreens && QGuiApplication::screens().size() > 1
+                     ? grabX11ShmScreens(rect)
+                     : grabber->grab(rect);
+    if (image.isNull()) {
+        return QPixmap();
+    }
+    QPixmap res = QPixmap::fromImage(std::move(image));
+    res.setDevicePixelRatio(ratio);
+    return res;
+#else
+    Q_UNUSED(rect)
+    Q_UNUSED(ratio)
+    Q_UNUSED(stitchScreens)
+    return QPixmap();
+#endif
+}
+
+// Device pixels of the area of the desktop window `geometry` scaled by `ratio`
+// (the coordinates of QScreen::grabWindow), restricted to `region` (relative
+// to that area) when it isn't null
+QRect devicePixels(const QRect& geometry, qreal ratio, const QRect& region)
+{
+    const QRect rect(geometry.topLeft() * ratio, geometry.size() * ratio);
+    if (region.isNull()) {
+        return rect;
+    }
+    return region.translated(rect.topLeft()).intersected(rect);
+}
+
+// Grab the desktop window area `geometry`, or only its device pixels `region`
+// with QScreen::grabWindow
+QPixmap grabDesktopWindow(QScreen* screen,
+                          const QRect& geometry,
+                          qreal ratio,
+                          const QRect& region)
+{
+    const WId desktop = QApplication::desktop()->winId();
+    if (region.isNull()) {
+        return screen->grabWindow(desktop,
+                                  geometry.x(),
+                                  geometry.y(),
+                                  geometry.width(),
+                                  geometry.height());
+    }
+    // Grab the smallest area containing the pixels and crop the fractional
+    // part
+    const QRect rect = devicePixels(geometry, ratio, region);
+    const QRectF logical(QPointF(rect.topLeft()) / ratio,
+                         QSizeF(rect.size()) / ratio);
+    const QRect aligned = logical.toAlignedRect();
+    QPixmap p = screen->grabWindow(
+      desktop, aligned.x(), aligned.y(), aligned.width(), aligned.height());
+    if (p.size() == rect.size()) {
+        return p;
+    }
+    const QPoint offset =
+      rect.topLeft() - (QPointF(aligned.topLeft()) * ratio).toPoint();
+    return p.copy(QRect(offset, rect.size()));
+}
+
+} // namespace
+
 ScreenGrabber::ScreenGrabber(QObject* parent)
   : QObject(parent)
 {}
 
-void ScreenGrabber::generalGrimScreenshot(bool& ok, QPixmap& res)
+void ScreenGrabber::generalGrimScreenshot(bool& ok,
+                                          QPixmap& res,
+                                          const QString& output,
+                                          const QRect& region,
+                                          qreal scale)
 {
 #ifdef USE_WAYLAND_GRIM
 #if defined(Q_OS_LINUX) || defined(Q_OS_UNIX)
-    QProcess Process;
-    QString program = "grim";
-    QStringList arguments;
-    arguments << "-";
-    Process.start(program, arguments);
-    if (Process.waitForFinished()) {
-        res.loadFromData(Process.readAll());
-        ok = true;
-    } else {
-        ok = false;
+    // Uncompressed output, encoding and decoding a PNG costs more than
+    // transferring the raw pixels
+    QStringList arguments{ QStringLiteral("-t"), QStringLiteral("ppm") };
+    if (!output.isEmpty()) {
+        arguments << QStringLiteral("-o") << output;
+    }
+    if (region.isValid()) {
+        arguments << QStringLiteral("-g")
+                  << QStringLiteral("%1,%2 %3x%4")
+                       .arg(region.x())
+                       .arg(region.y())
+                       .arg(region.width())
+                       .arg(region.height());
+    }
+    if (scale > 0) {
+        arguments << QStringLiteral("-s") << QString::number(scale);
+    }
+    arguments << QStringLiteral("-");
+
+    QProcess process;
+    process.start(QStringLiteral("grim"), arguments);
+    // Decode the rows while grim is still writing them
+    PpmStreamReader reader;
+    while (!reader.hasError() && process.waitForReadyRead()) {
+        reader.feed(process.readAllStandardOutput());
+    }
+    process.waitForFinished();
+    reader.feed(process.readAllStandardOutput());
+
+    ok = process.exitStatus() == QProcess::NormalExit &&
+         process.exitCode() == 0 && reader.isComplete();
+    if (ok) {
+        res = QPixmap::fromImage(reader.image());
+    } else if (process.error() == QProcess::FailedToStart) {
         AbstractLogger::error()
           << tr("The universal wayland screen capture adapter requires Grim as "
                 "the screen capture component of wayland. If the screen "
                 "capture component is missing, please install it!");
+    } else {
+        const QString error = reader.hasError()
+                                ? reader.errorString()
+                                : QString::fromLocal8Bit(
+                                    process.readAllStandardError().trimmed());
+        AbstractLogger::error() << tr("grim failed: %1").arg(error);
     }
 #endif
 #endif
 }
 
-void ScreenGrabber::freeDesktopPortal(bool& ok, QPixmap& res)
+void ScreenGrabber::grimPixels(bool& ok,
+                               QPixmap& res,
+                               const QRect& area,
+                               qreal scale,
+                               const QRect& region)
 {
+    const QRect pixels =
+      region.intersected(QRect(QPoint(0, 0), area.size() * scale));
+    if (pixels.isEmpty()) {
+        ok = false;
+        return;
+    }
+    // grim takes logical coordinates, grab the smallest area containing the
+    // pixels and crop the fractional part
+    const QRectF logical(area.topLeft() + QPointF(pixels.topLeft()) / scale,
+                         QSizeF(pixels.size()) / scale);
+    const QRect aligned = logical.toAlignedRect();
+    generalGrimScreenshot(ok, res, QString(), aligned, scale);
+    if (ok && res.size() != pixels.size()) {
+        const QPoint offset =
+          ((logical.topLeft() - aligned.topLeft()) * scale).toPoint();
+        res = res.copy(QRect(offset, pixels.size()));
+    }
+}
 
+void ScreenGrabber::freeDesktopPortal(const QRect& region,
+                                      QObject* context,
+                                      const Callback& callback)
+{
 #if defined(Q_OS_LINUX) || defined(Q_OS_UNIX)
-    QDBusInterface screenshotInterface(
-      QStringLiteral("org.freedesktop.portal.Desktop"),
-      QStringLiteral("/org/freedesktop/portal/desktop"),
-      QStringLiteral("org.freedesktop.portal.Screenshot"));
-
-    // unique token
-    QString token =
-      QUuid::createUuid().toString().remove('-').remove('{').remove('}');
-
-    // premake interface
-    auto* request = new OrgFreedesktopPortalRequestInterface(
-      QStringLiteral("org.freedesktop.portal.Desktop"),
-      "/org/freedesktop/portal/desktop/request/" +
-        QDBusConnection::sessionBus().baseService().remove(':').replace('.',
-                                                                        '_') +
-        "/" + token,
-      QDBusConnection::sessionBus(),
-      this);
-
-    QEventLoop loop;
-    const auto gotSignal = [&res, &loop](uint status, const QVariantMap& map) {
-        if (status == 0) {
-            // Parse this as URI to handle unicode properly
-            QUrl uri = map.value("uri").toString();
-            QString uriString = uri.toLocalFile();
-            res = QPixmap(uriString);
-            res.setDevicePixelRatio(qApp->devicePixelRatio());
-            QFile imgFile(uriString);
-            imgFile.remove();
-        }
-        loop.quit();
-    };
-
-    // prevent racy situations and listen before calling screenshot
-    QMetaObject::Connection conn = QObject::connect(
-      request, &org::freedesktop::portal::Request::Response, gotSignal);
+    PortalScreenshot::instance()->grabAsync(
+      region, context, [callback](const PortalScreenshot::Result& result) {
+#if defined(FLAMESHOT_PROFILE_CAPTURE)
+          AbstractLogger::info(AbstractLogger::Stderr)
+            << QStringLiteral(
+                 "Portal capture: %1 ms (portal %2 ms, decode %3 ms)")
+                 .arg(result.timings.total)
+                 .arg(result.timings.portal)
+                 .arg(result.timings.decode);
+#endif
+          if (result.image.isNull()) {
+              AbstractLogger::error() << result.error;
+              AbstractLogger::error() << ScreenGrabber::tr(
+                "Unable to capture screen");
+              callback(false, QPixmap());
+              return;
+          }
+          QPixmap res = QPixmap::fromImage(result.image);
+          res.setDevicePixelRatio(qApp->devicePixelRatio());
+          callback(true, res);
+      });
+#else
+    Q_UNUSED(region)
+    Q_UNUSED(context)
+    callback(false, QPixmap());
+#endif
+}
 
-    screenshotInterface.call(
-      QStringLiteral("Screenshot"),
-      "",
-      QMap<QString, QVariant>({ { "handle_token", QVariant(token) },
-                                { "interactive", QVariant(false) } }));
+bool ScreenGrabber::portalBackend()
+{
+#if !defined(Q_OS_MACOS) && (defined(Q_OS_LINUX) || defined(Q_OS_UNIX))
+    if (!m_info.waylandDetected()) {
+        return false;
+    }
+    switch (m_info.windowManager()) {
+        case DesktopInfo::GNOME:
+        case DesktopInfo::KDE:
+            return true;
+        case DesktopInfo::QTILE:
+        case DesktopInfo::SWAY:
+        case DesktopInfo::HYPRLAND:
+        case DesktopInfo::OTHER:
+            return !grimBackend();
+        default:
+            return false;
+    }
+#else
+    return false;
+#endif
+}
 
-    loop.exec();
-    QObject::disconnect(conn);
-    request->Close().waitForFinished();
-    request->deleteLater();
+void ScreenGrabber::grabEntireDesktopAsync(const QRect& region,
+                                           QObject* context,
+                                           const Callback& callback)
+{
+    if (!portalBackend()) {
+        bool ok = true;
+        const QPixmap res = grabEntireDesktop(ok, region);
+        callback(ok, res);
+        return;
+    }
+    if (m_info.windowManager() != DesktopInfo::GNOME &&
+        m_info.windowManager() != DesktopInfo::KDE) {
+        AbstractLogger::warning() << tr(
+          "If the USE_WAYLAND_GRIM option is not activated, the dbus "
+          "protocol will be used. It should be noted that using the "
+          "dbus protocol under wayland is not recommended. It is "
+          "recommended to recompile with the USE_WAYLAND_GRIM flag to "
+          "activate the grim-based general wayland screenshot adapter");
+    }
+    freeDesktopPortal(region, context, callback);
+}
 
-    if (res.isNull()) {
-        ok = false;
+void ScreenGrabber::grabScreenAsync(QScreen* screen,
+                                    const QRect& region,
+                                    QObject* context,
+                                    const Callback& callback)
+{
+    if (!portalBackend()) {
+        bool ok = true;
+        const QPixmap res = grabScreen(screen, ok, region);
+        callback(ok, res);
+        return;
     }
-#endif
+    // Like grabScreen, the screen is cropped from the desktop
+    const QRect geometry = screenGeometry(screen);
+    grabEntireDesktopAsync(
+      region.isNull()
+        ? geometry
+        : region.translated(geometry.topLeft()).intersected(geometry),
+      context,
+      callback);
 }
-QPixmap ScreenGrabber::grabEntireDesktop(bool& ok)
+
+QPixmap ScreenGrabber::grabEntireDesktop(bool& ok, const QRect& region)
 {
     ok = true;
 #if defined(Q_OS_MACOS)
@@ -118,46 +410,49 @@ QPixmap ScreenGrabber::grabEntireDesktop(bool& ok)
                                 currentScreen->geometry().width(),
                                 currentScreen->geometry().height()));
     screenPixmap.setDevicePixelRatio(currentScreen->devicePixelRatio());
+    if (!region.isNull()) {
+        return screenPixmap.copy(region);
+    }
     return screenPixmap;
 #elif defined(Q_OS_LINUX) || defined(Q_OS_UNIX)
     if (m_info.waylandDetected()) {
         QPixmap res;
-        // handle screenshot based on DE
-        switch (m_info.windowManager()) {
-            case DesktopInfo::GNOME:
-            case DesktopInfo::KDE:
-                freeDesktopPortal(ok, res);
-                break;
-            case DesktopInfo::QTILE:
-            case DesktopInfo::SWAY:
-            case DesktopInfo::HYPRLAND:
-            case DesktopInfo::OTHER: {
-#ifndef USE_WAYLAND_GRIM
-                AbstractLogger::warning() << tr(
-                  "If the USE_WAYLAND_GRIM option is not activated, the dbus "
-                  "protocol will be used. It should be noted that using the "
-                  "dbus protocol under wayland is not recommended. It is "
-                  "recommended to recompile with the USE_WAYLAND_GRIM flag to "
-                  "activate the grim-based general wayland screenshot adapter");
-                freeDesktopPortal(ok, res);
-#else
-                AbstractLogger::warning()
-                  << tr("grim's screenshot component is implemented based on "
-                        "wlroots, it may not be used in GNOME or similar "
-                        "desktop environments");
-                generalGrimScreenshot(ok, res);
+        if (portalBackend()) {
+            // The portal may ask the user for the permission first, it is
+            // only waited for in the event loop by grabEntireDesktopAsync
+            Q_ASSERT_X(false,
+                       "ScreenGrabber::grabEntireDesktop",
+                       "portal captures are asynchronous");
+            ok = false;
+        } else {
+            // handle screenshot based on DE
+            switch (m_info.windowManager()) {
+#ifdef USE_WAYLAND_GRIM
+                case DesktopInfo::QTILE:
+                case DesktopInfo::SWAY:
+                case DesktopInfo::HYPRLAND:
+                case DesktopInfo::OTHER:
+                    AbstractLogger::warning()
+                      << tr("grim's screenshot component is implemented based "
+                            "on wlroots, it may not be used in GNOME or "
+                            "similar desktop environments");
+                    if (region.isNull()) {
+                        generalGrimScreenshot(ok, res);
+                    } else {
+                        grimPixels(ok, res, grimLayout(), grimScale(), region);
+                    }
+                    break;
 #endif
-                break;
+                default:
+                    ok = false;
+                    AbstractLogger::error()
+                      << tr("Unable to detect desktop environment (GNOME? "
+                            "KDE? Qile? Sway? ...)");
+                    AbstractLogger::error()
+                      << tr("Hint: try setting the XDG_CURRENT_DESKTOP "
+                            "environment variable.");
+                    break;
             }
-            default:
-                ok = false;
-                AbstractLogger::error()
-                  << tr("Unable to detect desktop environment (GNOME? KDE? "
-                        "Qile? Sway? ...)");
-                AbstractLogger::error()
-                  << tr("Hint: try setting the XDG_CURRENT_DESKTOP environment "
-                        "variable.");
-                break;
         }
         if (!ok) {
             AbstractLogger::error() << tr("Unable to capture screen");
@@ -167,12 +462,12 @@ QPixmap ScreenGrabber::grabEntireDesktop(bool& ok)
 #endif
 #if defined(Q_OS_LINUX) || defined(Q_OS_UNIX) || defined(Q_OS_WIN)
     QRect geometry = desktopGeometry();
-    QPixmap p(QApplication::primaryScreen()->grabWindow(
-      QApplication::desktop()->winId(),
-      geometry.x(),
-      geometry.y(),
-      geometry.width(),
-      geometry.height()));
+    QScreen* primaryScreen = QApplication::primaryScreen();
+    const qreal ratio = primaryScreen->devicePixelRatio();
+    QPixmap p = grabX11Shm(devicePixels(geometry, ratio, region), ratio, true);
+    if (p.isNull()) {
+        p = grabDesktopWindow(primaryScreen, geometry, ratio, region);
+    }
     auto screenNumber = QApplication::desktop()->screenNumber();
     QScreen* screen = QApplication::screens()[screenNumber];
     p.setDevicePixelRatio(screen->devicePixelRatio());
@@ -204,24 +499,83 @@ QRect ScreenGrabber::screenGeometry(QScreen* screen)
     return geometry;
 }
 
-QPixmap ScreenGrabber::grabScreen(QScreen* screen, bool& ok)
+QPixmap ScreenGrabber::grabScreen(QScreen* screen,
+                                  bool& ok,
+                                  const QRect& region)
 {
     QPixmap p;
     QRect geometry = screenGeometry(screen);
     if (m_info.waylandDetected()) {
-        p = grabEntireDesktop(ok);
-        if (ok) {
-            return p.copy(geometry);
+        if (grimBackend()) {
+            // Only transfer the pixels of the screen
+            const QString output = screen->name();
+            if (!region.isNull()) {
+                grimPixels(ok,
+                           p,
+                           screen->geometry(),
+                           screen->devicePixelRatio(),
+                           region);
+            } else if (!output.isEmpty()) {
+                generalGrimScreenshot(ok, p, output);
+            } else {
+                generalGrimScreenshot(ok, p, QString(), screen->geometry());
+            }
+            if (ok) {
+                return p;
+            }
         }
-    } else {
-        ok = true;
-        return screen->grabWindow(QApplication::desktop()->winId(),
-                                  geometry.x(),
-                                  geometry.y(),
-                                  geometry.width(),
-                                  geometry.height());
+        return grabEntireDesktop(
+          ok,
+          region.isNull()
+            ? geometry
+            : region.translated(geometry.topLeft()).intersected(geometry));
     }
-    return p;
+    ok = true;
+    const qreal ratio = screen->devicePixelRatio();
+    p = grabX11Shm(devicePixels(geometry, ratio, region), ratio, false);
+    if (!p.isNull()) {
+        return p;
+    }
+    return grabDesktopWindow(screen, geometry, ratio, region);
+}
+
+bool ScreenGrabber::grimBackend()
+{
+#ifdef USE_WAYLAND_GRIM
+    if (!m_info.waylandDetected()) {
+        return false;
+    }
+    switch (m_info.windowManager()) {
+        case DesktopInfo::QTILE:
+        case DesktopInfo::SWAY:
+        case DesktopInfo::HYPRLAND:
+        case DesktopInfo::OTHER:
+            return true;
+        default:
+            return false;
+    }
+#else
+    return false;
+#endif
+}
+
+QRect ScreenGrabber::grimLayout()
+{
+    QRect layout;
+    for (QScreen* const screen : QGuiApplication::screens()) {
+        layout = layout.united(screen->geometry());
+    }
+    return layout;
+}
+
+qreal ScreenGrabber::grimScale()
+{
+    // Like grim, render everything at the highest scale of the outputs
+    qreal scale = 1;
+    for (QScreen* const screen : QGuiApplication::screens()) {
+        scale = qMax(scale, screen->devicePixelRatio());
+    }
+    return scale;
 }
 
 QRect ScreenGrabber::desktopGeometry()
@@ -6,19 +6,61 @@
 #include "src/utils/desktopinfo.h"
 #include <QObject>
 #include <QScreen>
+#include <functional>
 
 class ScreenGrabber : public QObject
 {
     Q_OBJECT
 public:
+    // Called with the capture, `ok` is false on failure
+    using Callback = std::function<void(bool ok, const QPixmap& pixmap)>;
+
     explicit ScreenGrabber(QObject* parent = nullptr);
-    QPixmap grabEntireDesktop(bool& ok);
+    // A non-null `region` restricts the capture to these pixels of the
+    // pixmap that would be returned for the whole desktop (or screen), the
+    // backends then only transfer and decode what they can of that region
+    QPixmap grabEntireDesktop(bool& ok, const QRect& region = QRect());
     QRect screenGeometry(QScreen* screen);
-    QPixmap grabScreen(QScreen* screenNumber, bool& ok);
-    void freeDesktopPortal(bool& ok, QPixmap& res);
-    void generalGrimScreenshot(bool& ok, QPixmap& res);
+    QPixmap grabScreen(QScreen* screenNumber,
+                       bool& ok,
+                       const QRect& region = QRect());
+    // Whether captures of this desktop go through xdg-desktop-portal, which
+    // can only be waited for asynchronously
+    bool portalBackend();
+    // Like grabEntireDesktop and grabScreen, without blocking on the portal:
+    // `callback` is then called later in the thread of `context`, and not at
+    // all if `context` is destroyed first. The other backends call it before
+    // returning.
+    void grabEntireDesktopAsync(const QRect& region,
+                                QObject* context,
+                                const Callback& callback);
+    void grabScreenAsync(QScreen* screen,
+                         const QRect& region,
+                         QObject* context,
+                         const Callback& callback);
+    void freeDesktopPortal(const QRect& region,
+                           QObject* context,
+                           const Callback& callback);
+    // Capture with grim, only `output` and/or `region` (in the compositor
+    // layout) rendered at `scale` when given
+    void generalGrimScreenshot(bool& ok,
+                               QPixmap& res,
+                               const QString& output = QString(),
+                               const QRect& region = QRect(),
+                               qreal scale = 0);
     QRect desktopGeometry();
 
 private:
+    // Whether Wayland captures of this desktop go through grim
+    bool grimBackend();
+    // Capture the pixels `region` of the layout `area` rendered at `scale`
+    void grimPixels(bool& ok,
+                    QPixmap& res,
+                    const QRect& area,
+                    qreal scale,
+                    const QRect& region);
+    QRect grimLayout();
+    qreal grimScale();
+
     DesktopInfo m_info;
 };
@@ -5,17 +5,17 @@
 #include "abstractlogger.h"
 #include "src/core/flameshot.h"
 #include "src/core/flameshotdaemon.h"
+#include "src/utils/capturemimedata.h"
+#include "src/utils/codecs.h"
 #include "src/utils/confighandler.h"
 #include "src/utils/filenamehandler.h"
 #include "src/utils/globalvalues.h"
-#include "utils/desktopinfo.h"
 
 #if USE_WAYLAND_CLIPBOARD
 #include <KSystemClipboard>
 #endif
 
 #include <QApplication>
-#include <QBuffer>
 #include <QClipboard>
 #include <QFileDialog>
 #include <QMessageBox>
@@ -27,44 +27,58 @@
 #include "src/widgets/capture/capturewidget.h"
 #endif
 
-bool saveToFilesystem(const QPixmap& capture,
-                      const QString& path,
-                      const QString& messagePrefix)
+bool writeToFilesystem(const EncodedCapture& capture,
+                       const QString& path,
+                       int jpegQuality,
+                       QString& error)
 {
-    QString completePath = FileNameHandler().properScreenshotPath(
-      path, ConfigHandler().saveAsFileExtension());
-    QFile file{ completePath };
+    QFile file{ path };
     file.open(QIODevice::WriteOnly);
 
-    bool okay;
-    QString saveExtension;
-    saveExtension = QFileInfo(completePath).suffix().toLower();
-    if (saveExtension == "jpg" || saveExtension == "jpeg") {
-        okay = capture.save(&file, nullptr, ConfigHandler().jpegQuality());
-    } else {
-        okay = capture.save(&file);
-    }
+    // The encoding is shared with the other sinks of the capture
+    const QByteArray data = capture.encodedFor(path, jpegQuality);
+    bool okay =
+      !data.isEmpty() && file.isOpen() && file.write(data) == data.size();
+    error = file.error() != QFile::NoError ? file.errorString() : QString();
+    return okay;
+}
 
+void notifySaved(bool okay,
+                 const QString& path,
+                 const QString& error,
+                 const QString& messagePrefix)
+{
     QString saveMessage = messagePrefix;
-    QString notificationPath = completePath;
+    QString notificationPath = path;
     if (!saveMessage.isEmpty()) {
         saveMessage += " ";
     }
 
     if (okay) {
-        saveMessage += QObject::tr("Capture saved as ") + completePath;
+        saveMessage += QObject::tr("Capture saved as ") + path;
         AbstractLogger::info().attachNotificationPath(notificationPath)
           << saveMessage;
     } else {
-        saveMessage += QObject::tr("Error trying to save as ") + completePath;
-        if (file.error() != QFile::NoError) {
-            saveMessage += ": " + file.errorString();
+        saveMessage += QObject::tr("Error trying to save as ") + path;
+        if (!error.isEmpty()) {
+            saveMessage += ": " + error;
         }
         notificationPath = "";
         AbstractLogger::error().attachNotificationPath(notificationPath)
           << saveMessage;
     }
+}
 
+bool saveToFilesystem(const EncodedCapture& capture,
+                      const QString& path,
+                      const QString& messagePrefix)
+{
+    QString completePath = FileNameHandler().properScreenshotPath(
+      path, ConfigHandler().saveAsFileExtension());
+    QString error;
+    bool okay = writeToFilesystem(
+      capture, completePath, ConfigHandler().jpegQuality(), error);
+    notifySaved(okay, completePath, error, messagePrefix);
     return okay;
 }
 
@@ -84,6 +98,9 @@ QString ShowSaveFileDialog(const QString& title, const QString& directory)
             mimeTypeList.append(mimeType);
         }
     }
+    if (!mimeTypeList.contains(Codecs::mimeType("qoi"))) {
+        mimeTypeList.append(Codecs::mimeType("qoi"));
+    }
     dialog.setMimeTypeFilters(mimeTypeList);
 
     QString suffix = ConfigHandler().saveAsFileExtension();
@@ -101,45 +118,45 @@ QString ShowSaveFileDialog(const QString& title, const QString& directory)
     }
 }
 
-void saveToClipboardMime(const QPixmap& capture, const QString& imageType)
+void saveToClipboardMime(const EncodedCapture& capture,
+                         const QString& imageType)
 {
-    QByteArray array;
-    QBuffer buffer{ &array };
-    QImageWriter imageWriter{ &buffer, imageType.toUpper().toUtf8() };
-    if (imageType == "jpeg") {
-        imageWriter.setQuality(ConfigHandler().jpegQuality());
-    }
-    imageWriter.write(capture.toImage());
+#ifdef USE_WAYLAND_CLIPBOARD
+    // KSystemClipboard copies the image when it takes the clipboard, it is
+    // encoded right away
+    QByteArray array =
+      capture.encodedAs(imageType.toUtf8(), ConfigHandler().jpegQuality());
 
-    QPixmap formattedPixmap;
-    bool isLoaded =
-      formattedPixmap.loadFromData(reinterpret_cast<uchar*>(array.data()),
-                                   array.size(),
-                                   imageType.toUpper().toUtf8());
-    if (isLoaded) {
+    if (!array.isEmpty()) {
 
         auto* mimeData = new QMimeData();
 
-#ifdef USE_WAYLAND_CLIPBOARD
-        mimeData->setImageData(formattedPixmap.toImage());
+        // The image as it is once encoded, e.g. with the JPEG artifacts
+        QPixmap formattedPixmap;
+        formattedPixmap.loadFromData(
+          array, imageType.toUpper().toUtf8().constData());
+        // Qt may not read the format back, e.g. QOI
+        mimeData->setImageData(formattedPixmap.isNull()
+                                 ? capture.image()
+                                 : formattedPixmap.toImage());
         mimeData->setData(QStringLiteral("x-kde-force-image-copy"),
                           QByteArray());
         KSystemClipboard::instance()->setMimeData(mimeData,
                                                   QClipboard::Clipboard);
-#else
-        mimeData->setData("image/" + imageType, array);
-        QApplication::clipboard()->setMimeData(mimeData);
-#endif
-
     } else {
         AbstractLogger::error()
           << QObject::tr("Error while saving to clipboard");
     }
+#else
+    // The formats are encoded when they are pasted
+    QApplication::clipboard()->setMimeData(
+      new CaptureMimeData(capture, imageType));
+#endif
 }
 
 // If data is saved to the clipboard before the notification is sent via
 // dbus, the application freezes.
-void saveToClipboard(const QPixmap& capture)
+void saveToClipboard(const EncodedCapture& capture)
 {
     // If we are able to properly save the file, save the file and copy to
     // clipboard.
@@ -151,26 +168,20 @@ void saveToClipboard(const QPixmap& capture)
     } else {
         AbstractLogger() << QObject::tr("Capture saved to clipboard.");
     }
-    if (ConfigHandler().useJpgForClipboard()) {
-        // FIXME - it doesn't work on MacOS
-        saveToClipboardMime(capture, "jpeg");
-    } else {
-        // Need to send message before copying to clipboard
-#if defined(Q_OS_LINUX) || defined(Q_OS_UNIX)
-        if (DesktopInfo().waylandDetected()) {
-            saveToClipboardMime(capture, "png");
-        } else {
-            QApplication::clipboard()->setPixmap(capture);
-        }
-#else
-        QApplication::clipboard()->setPixmap(capture);
-#endif
-    }
+    // Need to send message before copying to clipboard
+    // FIXME - JPEG doesn't work on MacOS
+    saveToClipboardMime(capture, clipboardFormat());
+}
+
+QString clipboardFormat()
+{
+    ConfigHandler config;
+    return config.useJpgForClipboard() ? QStringLiteral("jpeg")
+                                       : config.clipboardFormat();
 }
 
-bool saveToFilesystemGUI(const QPixmap& capture)
+QString chooseSavePath()
 {
-    bool okay = false;
     ConfigHandler config;
     QString defaultSavePath = ConfigHandler().savePath();
     if (defaultSavePath.isEmpty() || !QDir(defaultSavePath).exists() ||
@@ -195,21 +206,12 @@ bool saveToFilesystemGUI(const QPixmap& capture)
         savePath = QDir::toNativeSeparators(
           ShowSaveFileDialog(QObject::tr("Save screenshot"), savePath));
     }
-    if (savePath == "") {
-        return okay;
-    }
-
-    QFile file{ savePath };
-    file.open(QIODevice::WriteOnly);
-
-    QString saveExtension;
-    saveExtension = QFileInfo(savePath).suffix().toLower();
-    if (saveExtension == "jpg" || saveExtension == "jpeg") {
-        okay = capture.save(&file, nullptr, ConfigHandler().jpegQuality());
-    } else {
-        okay = capture.save(&file);
-    }
+    return savePath;
+}
 
+void notifySavedGUI(bool okay, const QString& savePath, const QString& error)
+{
+    ConfigHandler config;
     if (okay) {
         QString pathNoFile =
           savePath.left(savePath.lastIndexOf(QDir::separator()));
@@ -227,8 +229,8 @@ bool saveToFilesystemGUI(const QPixmap& capture)
     } else {
         QString msg = QObject::tr("Error trying to save as ") + savePath;
 
-        if (file.error() != QFile::NoError) {
-            msg += ": " + file.errorString();
+        if (!error.isEmpty()) {
+            msg += ": " + error;
         }
 
         QMessageBox saveErrBox(
@@ -236,6 +238,18 @@ bool saveToFilesystemGUI(const QPixmap& capture)
         saveErrBox.setWindowIcon(QIcon(GlobalValues::iconPath()));
         saveErrBox.exec();
     }
+}
+
+bool saveToFilesystemGUI(const EncodedCapture& capture)
+{
+    QString savePath = chooseSavePath();
+    if (savePath == "") {
+        return false;
+    }
 
+    QString error;
+    bool okay = writeToFilesystem(
+      capture, savePath, ConfigHandler().jpegQuality(), error);
+    notifySavedGUI(okay, savePath, error);
     return okay;
 }
@@ -3,14 +3,32 @@
 
 #pragma once
 
+#include "src/utils/encodedcapture.h"
 #include <QString>
 
-class QPixmap;
-
-bool saveToFilesystem(const QPixmap& capture,
+// Encode the capture for `path` and write it, which may be done in any
+// thread; `error` receives the reason of a failure when there is one
+bool writeToFilesystem(const EncodedCapture& capture,
+                       const QString& path,
+                       int jpegQuality,
+                       QString& error);
+// Report the result of writeToFilesystem like saveToFilesystem does
+void notifySaved(bool okay,
+                 const QString& path,
+                 const QString& error,
+                 const QString& messagePrefix = "");
+// Ask where to save a capture unless the save path is fixed, empty when the
+// dialog is cancelled
+QString chooseSavePath();
+// Report the result of writeToFilesystem like saveToFilesystemGUI does
+void notifySavedGUI(bool okay, const QString& savePath, const QString& error);
+bool saveToFilesystem(const EncodedCapture& capture,
                       const QString& path,
                       const QString& messagePrefix = "");
 QString ShowSaveFileDialog(const QString& title, const QString& directory);
-void saveToClipboardMime(const QPixmap& capture, const QString& imageType);
-void saveToClipboard(const QPixmap& capture);
-bool saveToFilesystemGUI(const QPixmap& capture);
+void saveToClipboardMime(const EncodedCapture& capture,
+                         const QString& imageType);
+void saveToClipboard(const EncodedCapture& capture);
+// The format captures are copied to the clipboard in
+QString clipboardFormat();
+bool saveToFilesystemGUI(const EncodedCapture& capture);
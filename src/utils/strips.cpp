@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "strips.h"
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <utility>
+
+namespace {
+
+class StripTask : public QRunnable
+{
+public:
+    StripTask(std::function<void()> function, QSemaphore* done)
+      : m_function(std::move(function))
+      , m_done(done)
+    {}
+
+    void run() override
+    {
+        m_function();
+        m_done->release();
+    }
+
+private:
+    std::function<void()> m_function;
+    QSemaphore* m_done;
+};
+
+} // namespace
+
+void forEachStrip(int count,
+                  int minStripSize,
+                  const std::function<void(int, int)>& function)
+{
+    QThreadPool* pool = QThreadPool::globalInstance();
+    const int strips =
+      qBound(1, count / qMax(1, minStripSize), qMax(1, pool->maxThreadCount()));
+    const int stripSize = (count + strips - 1) / strips;
+    QSemaphore done;
+    int started = 0;
+    for (int begin = stripSize; begin < count; begin += stripSize) {
+        const int end = qMin(count, begin + stripSize);
+        auto* task =
+          new StripTask([&function, begin, end]() { function(begin, end); },
+                        &done);
+        if (pool->tryStart(task)) {
+            ++started;
+        } else {
+            // No thread available, don't wait for one
+            task->run();
+            delete task;
+            done.acquire();
+        }
+    }
+    function(0, qMin(count, stripSize));
+    done.acquire(started);
+}
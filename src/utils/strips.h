@@ -0,0 +1,14 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <functional>
+
+// Split [0, count) into strips of at least `minStripSize` items, at most one
+// per thread of the global pool, and call `function(begin, end)` for each of
+// them. The first strip runs in the calling thread, which returns once all
+// the strips are done.
+void forEachStrip(int count,
+                  int minStripSize,
+                  const std::function<void(int, int)>& function);
@@ -0,0 +1,226 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "tiledpixmap.h"
+#include <QPainter>
+
+// Size of the tiles in device pixels
+#define TILE_SIZE 256
+
+template<typename Function>
+void TiledPixmap::forEachTile(const QRect& deviceRect, Function function) const
+{
+    if (deviceRect.isEmpty()) {
+        return;
+    }
+    for (int row = deviceRect.top() / TILE_SIZE;
+         row <= deviceRect.bottom() / TILE_SIZE;
+         ++row) {
+        for (int column = deviceRect.left() / TILE_SIZE;
+             column <= deviceRect.right() / TILE_SIZE;
+             ++column) {
+            function(row * m_columns + column, tileRect(column, row));
+        }
+    }
+}
+
+TiledPixmap::TiledPixmap()
+  : m_devicePixelRatio(1)
+  , m_columns(0)
+  , m_rows(0)
+{}
+
+TiledPixmap::TiledPixmap(const QPixmap& pixmap)
+  : m_size(pixmap.size())
+  , m_devicePixelRatio(pixmap.devicePixelRatio())
+  , m_columns((pixmap.width() + TILE_SIZE - 1) / TILE_SIZE)
+  , m_rows((pixmap.height() + TILE_SIZE - 1) / TILE_SIZE)
+{
+    m_tiles.reserve(m_columns * m_rows);
+    for (int row = 0; row < m_rows; ++row) {
+        for (int column = 0; column < m_columns; ++column) {
+            // QPixmap::copy keeps the device pixel ratio of the source
+            m_tiles.append(pixmap.copy(tileRect(column, row)));
+        }
+    }
+}
+
+bool TiledPixmap::isNull() const
+{
+    return m_tiles.isEmpty();
+}
+
+int TiledPixmap::width() const
+{
+    return m_size.width();
+}
+
+int TiledPixmap::height() const
+{
+    return m_size.height();
+}
+
+QSize TiledPixmap::size() const
+{
+    return m_size;
+}
+
+QRect TiledPixmap::rect() const
+{
+    return QRect(QPoint(0, 0), m_size);
+}
+
+qreal TiledPixmap::devicePixelRatio() const
+{
+    return m_devicePixelRatio;
+}
+
+QRect TiledPixmap::logicalRect() const
+{
+    return QRectF(QPointF(0, 0), QSizeF(m_size) / m_devicePixelRatio)
+      .toAlignedRect();
+}
+
+QPixmap TiledPixmap::copy(const QRect& rect) const
+{
+    const QRect area =
+      rect.isNull() ? this->rect() : rect.intersected(this->rect());
+    if (area.isEmpty()) {
+        return QPixmap();
+    }
+    // Most of the copies done by the tools fit in a single tile
+    const int column = area.left() / TILE_SIZE;
+    const int row = area.top() / TILE_SIZE;
+    if (column == area.right() / TILE_SIZE &&
+        row == area.bottom() / TILE_SIZE) {
+        const QRect tile = tileRect(column, row);
+        return m_tiles.at(row * m_columns + column)
+          .copy(area.translated(-tile.topLeft()));
+    }
+
+    QPixmap result(area.size());
+    result.fill(Qt::transparent);
+    QPainter painter(&result);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    forEachTile(area, [&](int index, const QRect& tile) {
+        const QRect source = tile.intersected(area);
+        // Explicit rects, the tiles have a device pixel ratio and the result
+        // doesn't have one yet
+        painter.drawPixmap(source.translated(-area.topLeft()),
+                           m_tiles.at(index),
+                           source.translated(-tile.topLeft()));
+    });
+    painter.end();
+    result.setDevicePixelRatio(m_devicePixelRatio);
+    return result;
+}
+
+TiledPixmap TiledPixmap::cropped(const QRegion& region) const
+{
+    TiledPixmap result(*this);
+    for (int row = 0; row < m_rows; ++row) {
+        for (int column = 0; column < m_columns; ++column) {
+            if (!region.intersects(logicalTileRect(column, row))) {
+                result.m_tiles[row * m_columns + column] = QPixmap();
+            }
+        }
+    }
+    return result;
+}
+
+QVector<qint64> TiledPixmap::cacheKeys(const QRect& rect) const
+{
+    QVector<qint64> keys;
+    forEachTile(rect.intersected(this->rect()),
+                [&](int index, const QRect& tile) {
+                    Q_UNUSED(tile)
+                    keys.append(m_tiles.at(index).cacheKey());
+                });
+    return keys;
+}
+
+void TiledPixmap::draw(QPainter& painter, const QRegion& region) const
+{
+    forEachTile(deviceRect(region.boundingRect()),
+                [&](int index, const QRect& tile) {
+                    const QPixmap& pixmap = m_tiles.at(index);
+                    if (!pixmap.isNull()) {
+                        painter.drawPixmap(
+                          QPointF(tile.topLeft()) / m_devicePixelRatio, pixmap);
+                    }
+                });
+}
+
+void TiledPixmap::paint(const QRegion& region,
+                        const std::function<void(QPainter&)>& callback)
+{
+    forEachTile(deviceRect(region.boundingRect()),
+                [&](int index, const QRect& tile) {
+                    QPixmap& pixmap = m_tiles[index];
+                    if (pixmap.isNull()) {
+                        return;
+                    }
+                    QPainter painter(&pixmap);
+                    painter.translate(-QPointF(tile.topLeft()) /
+                                      m_devicePixelRatio);
+                    painter.setClipRegion(region);
+                    callback(painter);
+                });
+}
+
+void TiledPixmap::restore(const TiledPixmap& other, const QRegion& region)
+{
+    if (other.m_size != m_size ||
+        other.m_devicePixelRatio != m_devicePixelRatio) {
+        return;
+    }
+    forEachTile(deviceRect(region.boundingRect()),
+                [&](int index, const QRect& tile) {
+                    const QPixmap& source = other.m_tiles.at(index);
+                    if (source.isNull()) {
+                        return;
+                    }
+                    const int column = index % m_columns;
+                    const int row = index / m_columns;
+                    if (QRegion(logicalTileRect(column, row))
+                          .subtracted(region)
+                          .isEmpty()) {
+                        // Share the whole tile instead of copying its pixels
+                        m_tiles[index] = source;
+                        return;
+                    }
+                    QPixmap& pixmap = m_tiles[index];
+                    if (pixmap.isNull()) {
+                        return;
+                    }
+                    const QPointF origin =
+                      QPointF(tile.topLeft()) / m_devicePixelRatio;
+                    QPainter painter(&pixmap);
+                    painter.setCompositionMode(
+                      QPainter::CompositionMode_Source);
+                    painter.translate(-origin);
+                    painter.setClipRegion(region);
+                    painter.drawPixmap(origin, source);
+                });
+}
+
+QRect TiledPixmap::tileRect(int column, int row) const
+{
+    return QRect(column * TILE_SIZE, row * TILE_SIZE, TILE_SIZE, TILE_SIZE)
+      .intersected(rect());
+}
+
+QRect TiledPixmap::logicalTileRect(int column, int row) const
+{
+    const QRect tile = tileRect(column, row);
+    return QRectF(QPointF(tile.topLeft()) / m_devicePixelRatio,
+                  QSizeF(tile.size()) / m_devicePixelRatio)
+      .toAlignedRect();
+}
+
+QRect TiledPixmap::deviceRect(const QRect& rect) const
+{
+    QRectF scaled(QPointF(rect.topLeft()) * m_devicePixelRatio,
+                  QSizeF(rect.size()) * m_devicePixelRatio);
+    return scaled.toAlignedRect().intersected(this->rect());
+}
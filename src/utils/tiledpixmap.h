@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QPixmap>
+#include <QRegion>
+#include <QVector>
+#include <functional>
+
+class QPainter;
+
+/**
+ * @brief Pixmap split into fixed size tiles.
+ *
+ * Tiles are implicitly shared QPixmaps, so copying a TiledPixmap is cheap and
+ * painting into it only detaches the tiles that are actually touched. This
+ * keeps the original and the annotated screenshot sharing every tile that
+ * has not been drawn on, even for very large desktops.
+ *
+ * Like QPixmap, `size()`, `rect()` and `copy()` use device pixels while the
+ * painting functions use logical (device independent) coordinates.
+ */
+class TiledPixmap
+{
+public:
+    TiledPixmap();
+    explicit TiledPixmap(const QPixmap& pixmap);
+
+    bool isNull() const;
+    int width() const;
+    int height() const;
+    QSize size() const;
+    QRect rect() const;
+    qreal devicePixelRatio() const;
+    // Logical size, i.e. the size of the area covered on the screen
+    QRect logicalRect() const;
+
+    // Same as QPixmap::copy, only the tiles intersecting `rect` are read
+    QPixmap copy(const QRect& rect = QRect()) const;
+    // Same as copy() but tiles outside of `region` are dropped instead of
+    // being copied, the result shares the remaining tiles
+    TiledPixmap cropped(const QRegion& region) const;
+    // Cache keys of the tiles intersecting `rect` (device pixels), they change
+    // whenever one of these tiles is painted
+    QVector<qint64> cacheKeys(const QRect& rect) const;
+
+    // Draw the tiles intersecting `region` with their top-left corner at the
+    // origin of the painter
+    void draw(QPainter& painter, const QRegion& region) const;
+    // Call `callback` for every tile intersecting `region`, with a painter
+    // translated to the tile and clipped to `region`
+    void paint(const QRegion& region,
+               const std::function<void(QPainter&)>& callback);
+    // Replace the pixels inside `region` by the pixels of `other`, tiles
+    // fully covered by `region` are shared instead of being copied
+    void restore(const TiledPixmap& other, const QRegion& region);
+
+private:
+    QRect tileRect(int column, int row) const;
+    QRect logicalTileRect(int column, int row) const;
+    QRect deviceRect(const QRect& rect) const;
+    template<typename Function>
+    void forEachTile(const QRect& deviceRect, Function function) const;
+
+    // class members
+    QSize m_size;
+    qreal m_devicePixelRatio;
+    int m_columns;
+    int m_rows;
+    QVector<QPixmap> m_tiles;
+};
@@ -1,11 +1,11 @@
 #include "valuehandler.h"
 #include "capturetool.h"
+#include "codecs.h"
 #include "colorpickerwidget.h"
 #include "confighandler.h"
 #include "screengrabber.h"
 #include <QColor>
 #include <QFileInfo>
-#include <QImageWriter>
 #include <QKeySequence>
 #include <QStandardPaths>
 #include <QVariant>
@@ -507,11 +507,7 @@ bool SaveFileExtension::check(const QVariant& val)
         extension.remove(0, 1);
     }
 
-    QStringList imageFormatList;
-    foreach (auto imageFormat, QImageWriter::supportedImageFormats())
-        imageFormatList.append(imageFormat);
-
-    if (!imageFormatList.contains(extension)) {
+    if (!Codecs::formats().contains(extension)) {
         return false;
     }
 
@@ -534,6 +530,51 @@ QString SaveFileExtension::expected()
     return QStringLiteral("supported image extension");
 }
 
+// IMAGE FORMAT
+
+ImageFormat::ImageFormat(QString def)
+  : m_def(std::move(def))
+{}
+
+bool ImageFormat::check(const QVariant& val)
+{
+    return val.canConvert(QVariant::String) &&
+           Codecs::formats().contains(val.toString().toLower());
+}
+
+QVariant ImageFormat::fallback()
+{
+    return m_def;
+}
+
+QString ImageFormat::expected()
+{
+    return QStringLiteral("supported image format");
+}
+
+QVariant ImageFormat::process(const QVariant& val)
+{
+    return val.toString().toLower();
+}
+
+// ENCODING PRESET
+
+bool EncodingPreset::check(const QVariant& val)
+{
+    return val.canConvert(QVariant::String) &&
+           Codecs::presetNames().contains(val.toString());
+}
+
+QVariant EncodingPreset::fallback()
+{
+    return QStringLiteral("balanced");
+}
+
+QString EncodingPreset::expected()
+{
+    return Codecs::presetNames().join(QStringLiteral(", "));
+}
+
 // REGION
 
 bool Region::check(const QVariant& val)
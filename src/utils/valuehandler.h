@@ -225,6 +225,28 @@ class SaveFileExtension : public ValueHandler
     QString expected() override;
 };
 
+class ImageFormat : public ValueHandler
+{
+public:
+    ImageFormat(QString def);
+    bool check(const QVariant& val) override;
+    QVariant fallback() override;
+    QString expected() override;
+
+private:
+    QVariant process(const QVariant& val) override;
+
+    QString m_def;
+};
+
+class EncodingPreset : public ValueHandler
+{
+public:
+    bool check(const QVariant& val) override;
+    QVariant fallback() override;
+    QString expected() override;
+};
+
 class Region : public ValueHandler
 {
 public:
@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "windowindex.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+#include <algorithm>
+#include <utility>
+
+#if defined(USE_XCB)
+#include <cstdlib>
+#include <xcb/xcb.h>
+#endif
+
+struct WindowIndex::State
+{
+    mutable QMutex mutex;
+    QVector<QRect> windows;
+    // Sorted edges of the windows, the grid lines
+    QVector<int> xs;
+    QVector<int> ys;
+    // Topmost window of every cell of the grid, -1 for none
+    QVector<int> cells;
+
+    void build(const QVector<QRect>& rects);
+};
+
+namespace {
+
+// Visible top-level windows, from the bottom-most to the topmost one
+QVector<QRect> queryWindows()
+{
+    QVector<QRect> windows;
+#if defined(USE_XCB)
+    xcb_connection_t* connection = xcb_connect(nullptr, nullptr);
+    if (xcb_connection_has_error(connection)) {
+        xcb_disconnect(connection);
+        return windows;
+    }
+    const xcb_screen_t* screen =
+      xcb_setup_roots_iterator(xcb_get_setup(connection)).data;
+    xcb_query_tree_reply_t* tree = xcb_query_tree_reply(
+      connection, xcb_query_tree(connection, screen->root), nullptr);
+    if (tree != nullptr) {
+        const int count = xcb_query_tree_children_length(tree);
+        const xcb_window_t* children = xcb_query_tree_children(tree);
+        // All the requests are sent before waiting for the first reply
+        QVector<xcb_get_window_attributes_cookie_t> attributes(count);
+        QVector<xcb_get_geometry_cookie_t> geometries(count);
+        for (int i = 0; i < count; ++i) {
+            attributes[i] = xcb_get_window_attributes(connection, children[i]);
+            geometries[i] = xcb_get_geometry(connection, children[i]);
+        }
+        for (int i = 0; i < count; ++i) {
+            xcb_get_window_attributes_reply_t* attribute =
+              xcb_get_window_attributes_reply(
+                connection, attributes[i], nullptr);
+            xcb_get_geometry_reply_t* geometry =
+              xcb_get_geometry_reply(connection, geometries[i], nullptr);
+            // Override-redirect windows are menus, tooltips and the capture
+            // window itself
+            if (attribute != nullptr && geometry != nullptr &&
+                attribute->map_state == XCB_MAP_STATE_VIEWABLE &&
+                !attribute->override_redirect &&
+                attribute->_class == XCB_WINDOW_CLASS_INPUT_OUTPUT) {
+                const int border = geometry->border_width;
+                windows.append(QRect(geometry->x,
+                                     geometry->y,
+                                     geometry->width + 2 * border,
+                                     geometry->height + 2 * border));
+            }
+            std::free(attribute);
+            std::free(geometry);
+        }
+        std::free(tree);
+    }
+    xcb_disconnect(connection);
+#endif
+    return windows;
+}
+
+// Index of the grid line at `value`, or of the cell containing it
+int lineIndex(const QVector<int>& lines, int value)
+{
+    return static_cast<int>(
+      std::lower_bound(lines.begin(), lines.end(), value) - lines.begin());
+}
+
+int cellIndex(const QVector<int>& lines, int value)
+{
+    return static_cast<int>(
+             std::upper_bound(lines.begin(), lines.end(), value) -
+             lines.begin()) -
+           1;
+}
+
+} // namespace
+
+class WindowIndex::LoadTask : public QRunnable
+{
+public:
+    explicit LoadTask(QSharedPointer<State> state)
+      : m_state(std::move(state))
+    {}
+
+    void run() override { m_state->build(queryWindows()); }
+
+private:
+    QSharedPointer<State> m_state;
+};
+
+void WindowIndex::State::build(const QVector<QRect>& rects)
+{
+    QVector<int> lefts, tops;
+    for (const QRect& rect : rects) {
+        lefts << rect.left() << rect.right() + 1;
+        tops << rect.top() << rect.bottom() + 1;
+    }
+    std::sort(lefts.begin(), lefts.end());
+    lefts.erase(std::unique(lefts.begin(), lefts.end()), lefts.end());
+    std::sort(tops.begin(), tops.end());
+    tops.erase(std::unique(tops.begin(), tops.end()), tops.end());
+
+    // Paint the windows on the grid from the bottom, the topmost one wins
+    const int columns = qMax(0, lefts.size() - 1);
+    const int rows = qMax(0, tops.size() - 1);
+    QVector<int> grid(columns * rows, -1);
+    for (int i = 0; i < rects.size(); ++i) {
+        const QRect& rect = rects.at(i);
+        const int right = lineIndex(lefts, rect.right() + 1);
+        const int bottom = lineIndex(tops, rect.bottom() + 1);
+        for (int row = lineIndex(tops, rect.top()); row < bottom; ++row) {
+            const int left = lineIndex(lefts, rect.left());
+            std::fill(grid.begin() + row * columns + left,
+                      grid.begin() + row * columns + right,
+                      i);
+        }
+    }
+
+    QMutexLocker locker(&mutex);
+    windows = rects;
+    xs = std::move(lefts);
+    ys = std::move(tops);
+    cells = std::move(grid);
+}
+
+WindowIndex::WindowIndex()
+  : m_state(new State())
+{}
+
+void WindowIndex::load()
+{
+    QThreadPool::globalInstance()->start(new LoadTask(m_state));
+}
+
+void WindowIndex::setWindows(const QVector<QRect>& windows)
+{
+    m_state->build(windows);
+}
+
+QRect WindowIndex::windowAt(const QPoint& pos) const
+{
+    const State& state = *m_state;
+    QMutexLocker locker(&state.mutex);
+    const int column = cellIndex(state.xs, pos.x());
+    const int row = cellIndex(state.ys, pos.y());
+    const int columns = state.xs.size() - 1;
+    if (column < 0 || row < 0 || column >= columns ||
+        row >= state.ys.size() - 1) {
+        return QRect();
+    }
+    const int window = state.cells.at(row * columns + column);
+    return window < 0 ? QRect() : state.windows.at(window);
+}
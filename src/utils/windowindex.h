@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QRect>
+#include <QSharedPointer>
+#include <QVector>
+
+/**
+ * @brief The visible top-level windows of the desktop, to snap the selection
+ * to the window under the cursor.
+ *
+ * `load` queries the X11 window tree once, in a background thread. The
+ * windows are then indexed on a grid made of their edges: every cell knows
+ * the topmost window covering it, so `windowAt` is two binary searches.
+ * Until the query is done (and where X11 is not used) no window is found.
+ */
+class WindowIndex
+{
+public:
+    WindowIndex();
+
+    // Query the windows in a background thread
+    void load();
+    // Index these rects, stacked from the bottom-most to the topmost one
+    void setWindows(const QVector<QRect>& windows);
+    // The topmost window containing `pos`, in native pixels of the root
+    // window; a null rect when there is none
+    QRect windowAt(const QPoint& pos) const;
+
+private:
+    struct State;
+    class LoadTask;
+
+    QSharedPointer<State> m_state;
+};
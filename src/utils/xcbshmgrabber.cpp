@@ -0,0 +1,259 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "xcbshmgrabber.h"
+#include "abstractlogger.h"
+#include <QMutexLocker>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <xcb/shm.h>
+#include <xcb/xcb.h>
+
+// Number of unused segments kept for the next grabs, a capture of every
+// screen in parallel needs one per screen
+#define MAX_FREE_SEGMENTS 4
+
+XcbShmGrabber::XcbShmGrabber()
+  : m_connection(nullptr)
+  , m_root(0)
+  , m_format(QImage::Format_Invalid)
+  , m_available(0)
+{
+    if (connect()) {
+        m_available.storeRelease(1);
+    } else {
+        disconnect();
+    }
+}
+
+XcbShmGrabber::~XcbShmGrabber()
+{
+    QMutexLocker locker(&m_mutex);
+    for (Segment* segment : qAsConst(m_freeSegments)) {
+        destroySegment(segment);
+    }
+    m_freeSegments.clear();
+    locker.unlock();
+    disconnect();
+}
+
+XcbShmGrabber* XcbShmGrabber::instance()
+{
+    static XcbShmGrabber grabber;
+    return &grabber;
+}
+
+bool XcbShmGrabber::isAvailable() const
+{
+    return m_available.loadAcquire() != 0;
+}
+
+QSize XcbShmGrabber::rootSize() const
+{
+    if (!isAvailable()) {
+        return QSize();
+    }
+    // Asked every time, xrandr and new monitors resize the root window while
+    // the daemon runs
+    xcb_get_geometry_reply_t* geometry = xcb_get_geometry_reply(
+      m_connection, xcb_get_geometry(m_connection, m_root), nullptr);
+    if (geometry == nullptr) {
+        return QSize();
+    }
+    const QSize size(geometry->width, geometry->height);
+    free(geometry);
+    return size;
+}
+
+bool XcbShmGrabber::connect()
+{
+    int screenNumber = 0;
+    m_connection = xcb_connect(nullptr, &screenNumber);
+    if (xcb_connection_has_error(m_connection)) {
+        return false;
+    }
+
+    const xcb_query_extension_reply_t* extension =
+      xcb_get_extension_data(m_connection, &xcb_shm_id);
+    if (extension == nullptr || !extension->present) {
+        return false;
+    }
+    xcb_shm_query_version_reply_t* version = xcb_shm_query_version_reply(
+      m_connection, xcb_shm_query_version(m_connection), nullptr);
+    if (version == nullptr) {
+        return false;
+    }
+    free(version);
+
+    const xcb_setup_t* setup = xcb_get_setup(m_connection);
+    xcb_screen_iterator_t screens = xcb_setup_roots_iterator(setup);
+    for (; screens.rem > 0 && screenNumber > 0; --screenNumber) {
+        xcb_screen_next(&screens);
+    }
+    if (screens.rem == 0) {
+        return false;
+    }
+    const xcb_screen_t* screen = screens.data;
+    m_root = screen->root;
+
+    // Only 32 bits per pixel in the native byte order can be wrapped as is
+    if (setup->image_byte_order != XCB_IMAGE_ORDER_LSB_FIRST) {
+        return false;
+    }
+    switch (screen->root_depth) {
+        case 24:
+        case 32:
+            m_format = QImage::Format_RGB32;
+            break;
+        case 30:
+            m_format = QImage::Format_RGB30;
+            break;
+        default:
+            return false;
+    }
+    xcb_format_iterator_t formats = xcb_setup_pixmap_formats_iterator(setup);
+    for (; formats.rem > 0; xcb_format_next(&formats)) {
+        if (formats.data->depth == screen->root_depth) {
+            return formats.data->bits_per_pixel == 32;
+        }
+    }
+    return false;
+}
+
+void XcbShmGrabber::disconnect()
+{
+    if (m_connection != nullptr) {
+        xcb_disconnect(m_connection);
+        m_connection = nullptr;
+    }
+}
+
+QImage::Format XcbShmGrabber::format() const
+{
+    return m_format;
+}
+
+QImage XcbShmGrabber::grab(const QRect& rect)
+{
+    if (m_available.loadAcquire() == 0 || rect.isEmpty()) {
+        return QImage();
+    }
+    const int bytesPerLine = rect.width() * 4;
+    Segment* segment =
+      takeSegment(static_cast<size_t>(bytesPerLine) * rect.height());
+    if (segment == nullptr) {
+        return QImage();
+    }
+
+    xcb_generic_error_t* error = nullptr;
+    xcb_shm_get_image_reply_t* reply = xcb_shm_get_image_reply(
+      m_connection,
+      xcb_shm_get_image(m_connection,
+                        m_root,
+                        rect.x(),
+                        rect.y(),
+                        rect.width(),
+                        rect.height(),
+                        ~0U,
+                        XCB_IMAGE_FORMAT_Z_PIXMAP,
+                        segment->id,
+                        0),
+      &error);
+    free(reply);
+    if (error != nullptr) {
+        // Most likely a rect outside of the root window
+        AbstractLogger::error()
+          << QStringLiteral("MIT-SHM grab failed with X error %1")
+               .arg(error->error_code);
+        free(error);
+        releaseSegment(segment);
+        return QImage();
+    }
+
+    // The segment goes back to the pool when the image (and all its shallow
+    // copies) is destroyed
+    return QImage(segment->data,
+                  rect.width(),
+                  rect.height(),
+                  bytesPerLine,
+                  m_format,
+                  imageCleanup,
+                  segment);
+}
+
+XcbShmGrabber::Segment* XcbShmGrabber::takeSegment(size_t size)
+{
+    QMutexLocker locker(&m_mutex);
+    // Smallest free segment big enough
+    int best = -1;
+    for (int i = 0; i < m_freeSegments.size(); ++i) {
+        const size_t segmentSize = m_freeSegments.at(i)->size;
+        if (segmentSize >= size &&
+            (best < 0 || segmentSize < m_freeSegments.at(best)->size)) {
+            best = i;
+        }
+    }
+    if (best >= 0) {
+        return m_freeSegments.takeAt(best);
+    }
+    return createSegment(size);
+}
+
+XcbShmGrabber::Segment* XcbShmGrabber::createSegment(size_t size)
+{
+    const int shmId = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+    if (shmId < 0) {
+        AbstractLogger::error() << QStringLiteral(
+          "Unable to allocate a shared memory segment for the screen grab");
+        return nullptr;
+    }
+    void* data = shmat(shmId, nullptr, 0);
+    if (data == reinterpret_cast<void*>(-1)) {
+        shmctl(shmId, IPC_RMID, nullptr);
+        return nullptr;
+    }
+
+    auto* segment = new Segment{
+        this, xcb_generate_id(m_connection), shmId, static_cast<uchar*>(data),
+        size
+    };
+    xcb_generic_error_t* error = xcb_request_check(
+      m_connection,
+      xcb_shm_attach_checked(m_connection, segment->id, shmId, false));
+    // Once the server is attached, the segment can be marked for deletion:
+    // it is freed when both sides detach, even if we crash
+    shmctl(shmId, IPC_RMID, nullptr);
+    if (error != nullptr) {
+        // Typically a remote display, don't try again
+        free(error);
+        shmdt(data);
+        delete segment;
+        m_available.storeRelease(0);
+        return nullptr;
+    }
+    return segment;
+}
+
+void XcbShmGrabber::releaseSegment(Segment* segment)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_freeSegments.size() < MAX_FREE_SEGMENTS) {
+        m_freeSegments.append(segment);
+    } else {
+        destroySegment(segment);
+    }
+}
+
+void XcbShmGrabber::destroySegment(Segment* segment)
+{
+    xcb_shm_detach(m_connection, segment->id);
+    xcb_flush(m_connection);
+    shmdt(segment->data);
+    delete segment;
+}
+
+void XcbShmGrabber::imageCleanup(void* segment)
+{
+    auto* s = static_cast<Segment*>(segment);
+    s->grabber->releaseSegment(s);
+}
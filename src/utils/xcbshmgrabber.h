@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QAtomicInt>
+#include <QImage>
+#include <QMutex>
+#include <QRect>
+#include <QVector>
+
+struct xcb_connection_t;
+
+/**
+ * @brief Grabs the X11 root window through the MIT-SHM extension.
+ *
+ * The X server writes the pixels straight into a shared memory segment which
+ * is wrapped by the returned QImage, there is no copy and no image conversion
+ * on our side. Segments are given back to a small pool when the last image
+ * using them is destroyed and reused by the next grabs, so repeated captures
+ * don't allocate either.
+ *
+ * The grabber opens its own connection to $DISPLAY. It is unavailable on
+ * remote displays, without the extension or with unusual visuals, callers
+ * must then fall back to `QScreen::grabWindow`. `grab` can be called from any
+ * thread.
+ */
+class XcbShmGrabber
+{
+public:
+    static XcbShmGrabber* instance();
+
+    bool isAvailable() const;
+    // Current size of the root window in device pixels, asked to the server
+    QSize rootSize() const;
+    // Format of the grabbed images
+    QImage::Format format() const;
+    // Grab `rect` (root window coordinates, device pixels), returns a null
+    // image on failure
+    QImage grab(const QRect& rect);
+
+private:
+    XcbShmGrabber();
+    ~XcbShmGrabber();
+
+    struct Segment
+    {
+        XcbShmGrabber* grabber;
+        quint32 id;
+        int shmId;
+        uchar* data;
+        size_t size;
+    };
+
+    bool connect();
+    void disconnect();
+    Segment* takeSegment(size_t size);
+    Segment* createSegment(size_t size);
+    void releaseSegment(Segment* segment);
+    void destroySegment(Segment* segment);
+    static void imageCleanup(void* segment);
+
+    // class members
+    xcb_connection_t* m_connection;
+    quint32 m_root;
+    QImage::Format m_format;
+    // Cleared by `takeSegment` while the other screens may be grabbing
+    QAtomicInt m_available;
+
+    QMutex m_mutex;
+    QVector<Segment*> m_freeSegments;
+};
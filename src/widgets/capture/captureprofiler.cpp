@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "captureprofiler.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QFontMetrics>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <algorithm>
+#include <numeric>
+
+// Maximum number of events kept for the trace, later events only update the
+// HUD
+#define MAX_TRACE_EVENTS 1000000
+// Weight of the last frame in the averages shown by the HUD
+#define HUD_AVERAGE_WEIGHT 0.1
+#define HUD_MARGIN 10
+#define HUD_PADDING 6
+
+namespace {
+
+QString milliseconds(double nanoseconds)
+{
+    return QString::number(nanoseconds / 1000000.0, 'f', 2);
+}
+
+} // namespace
+
+CaptureProfiler::Scope::Scope(const QString& name)
+  : m_name(instance()->nameId(name))
+  , m_start(instance()->m_timer.nsecsElapsed())
+{}
+
+CaptureProfiler::Scope::~Scope()
+{
+    CaptureProfiler* profiler = instance();
+    profiler->record(m_name,
+                     m_start,
+                     profiler->m_timer.nsecsElapsed() - m_start);
+}
+
+CaptureProfiler::CaptureProfiler()
+  : m_lastFrameEnd(-1)
+  , m_frameInterval(0)
+{
+    m_timer.start();
+}
+
+CaptureProfiler* CaptureProfiler::instance()
+{
+    static CaptureProfiler profiler;
+    return &profiler;
+}
+
+int CaptureProfiler::nameId(const QString& name)
+{
+    auto it = m_nameIds.constFind(name);
+    if (it != m_nameIds.constEnd()) {
+        return it.value();
+    }
+    const int id = m_names.size();
+    m_names.append(name);
+    m_nameIds.insert(name, id);
+    m_stats.append(Stats());
+    return id;
+}
+
+void CaptureProfiler::record(int name, qint64 start, qint64 duration)
+{
+    if (m_events.size() < MAX_TRACE_EVENTS) {
+        m_events.append({ name, start, duration });
+    }
+    Stats& stats = m_stats[name];
+    stats.frameTotal += duration;
+    ++stats.calls;
+}
+
+void CaptureProfiler::newFrame()
+{
+    const qint64 now = m_timer.nsecsElapsed();
+    if (m_lastFrameEnd >= 0) {
+        const double interval = now - m_lastFrameEnd;
+        m_frameInterval =
+          m_frameInterval == 0
+            ? interval
+            : m_frameInterval * (1 - HUD_AVERAGE_WEIGHT) +
+                interval * HUD_AVERAGE_WEIGHT;
+    }
+    m_lastFrameEnd = now;
+
+    for (Stats& stats : m_stats) {
+        if (stats.calls == 0) {
+            continue;
+        }
+        stats.last = stats.frameTotal;
+        stats.max = qMax(stats.max, stats.last);
+        stats.average = stats.average == 0
+                          ? stats.last
+                          : stats.average * (1 - HUD_AVERAGE_WEIGHT) +
+                              stats.last * HUD_AVERAGE_WEIGHT;
+        stats.frameTotal = 0;
+        stats.calls = 0;
+    }
+}
+
+QRect CaptureProfiler::drawHud(QPainter& painter)
+{
+    QStringList lines;
+    if (m_frameInterval > 0) {
+        lines << QStringLiteral("frame interval %1 ms (%2 fps)")
+                   .arg(milliseconds(m_frameInterval))
+                   .arg(qRound(1000000000.0 / m_frameInterval));
+    }
+    QVector<int> names(m_names.size());
+    std::iota(names.begin(), names.end(), 0);
+    std::sort(names.begin(), names.end(), [this](int a, int b) {
+        return m_names.at(a) < m_names.at(b);
+    });
+    for (int name : qAsConst(names)) {
+        const Stats& stats = m_stats.at(name);
+        lines << QStringLiteral("%1: %2 ms, avg %3, max %4")
+                   .arg(m_names.at(name))
+                   .arg(milliseconds(stats.last))
+                   .arg(milliseconds(stats.average))
+                   .arg(milliseconds(stats.max));
+    }
+
+    painter.save();
+    const QFontMetrics metrics = painter.fontMetrics();
+    int width = 0;
+    for (const QString& line : qAsConst(lines)) {
+        width = qMax(width, metrics.horizontalAdvance(line));
+    }
+    QRect rect(HUD_MARGIN,
+               HUD_MARGIN,
+               width + 2 * HUD_PADDING,
+               lines.size() * metrics.height() + 2 * HUD_PADDING);
+    painter.fillRect(rect, QColor(0, 0, 0, 180));
+    painter.setPen(Qt::white);
+    painter.drawText(rect.adjusted(HUD_PADDING, HUD_PADDING, 0, 0),
+                     Qt::AlignLeft | Qt::AlignTop,
+                     lines.join('\n'));
+    painter.restore();
+
+    m_hudRect = m_hudRect.united(rect);
+    return rect;
+}
+
+QRect CaptureProfiler::hudRect() const
+{
+    return m_hudRect;
+}
+
+bool CaptureProfiler::writeChromeTrace(const QString& path) const
+{
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+    for (const Event& event : m_events) {
+        QJsonObject object;
+        object.insert(QStringLiteral("name"), m_names.at(event.name));
+        object.insert(QStringLiteral("cat"), QStringLiteral("capture"));
+        object.insert(QStringLiteral("ph"), QStringLiteral("X"));
+        // Chrome traces use microseconds
+        object.insert(QStringLiteral("ts"), event.start / 1000.0);
+        object.insert(QStringLiteral("dur"), event.duration / 1000.0);
+        object.insert(QStringLiteral("pid"), pid);
+        object.insert(QStringLiteral("tid"), 0);
+        events.append(object);
+    }
+    QJsonObject trace;
+    trace.insert(QStringLiteral("traceEvents"), events);
+    trace.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    const QByteArray data = QJsonDocument(trace).toJson(QJsonDocument::Compact);
+    return file.write(data) == data.size();
+}
+
+void CaptureProfiler::clear()
+{
+    m_events.clear();
+    for (Stats& stats : m_stats) {
+        stats = Stats();
+    }
+    m_lastFrameEnd = -1;
+    m_frameInterval = 0;
+    m_hudRect = QRect();
+}
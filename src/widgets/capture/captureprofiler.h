@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QRect>
+#include <QString>
+#include <QVector>
+
+class QPainter;
+
+/**
+ * @brief Records where the time of the capture editor goes.
+ *
+ * Enabled with -DFLAMESHOT_PROFILE_CAPTURE=ON. Scopes are timed with
+ * `CAPTURE_PROFILE_SCOPE(name)`, the totals of the last frame are shown in a
+ * HUD on top of the capture and all the scopes can be saved as a Chrome trace
+ * (chrome://tracing, https://ui.perfetto.dev). Without the option the macro
+ * expands to nothing, its argument isn't even evaluated.
+ */
+class CaptureProfiler
+{
+public:
+    // Times the enclosing scope
+    class Scope
+    {
+    public:
+        explicit Scope(const QString& name);
+        ~Scope();
+
+    private:
+        int m_name;
+        qint64 m_start;
+    };
+
+    static CaptureProfiler* instance();
+
+    // Called when a paint event of the capture widget starts, the HUD shows
+    // the totals of the previous frame
+    void newFrame();
+    // Draw the HUD in the top-left corner and return the painted rect
+    QRect drawHud(QPainter& painter);
+    QRect hudRect() const;
+
+    bool writeChromeTrace(const QString& path) const;
+    void clear();
+
+private:
+    CaptureProfiler();
+
+    struct Event
+    {
+        int name;
+        qint64 start;
+        qint64 duration;
+    };
+
+    struct Stats
+    {
+        qint64 frameTotal = 0;
+        qint64 last = 0;
+        qint64 max = 0;
+        double average = 0;
+        int calls = 0;
+    };
+
+    int nameId(const QString& name);
+    void record(int name, qint64 start, qint64 duration);
+
+    // class members
+    QElapsedTimer m_timer;
+    QVector<QString> m_names;
+    QHash<QString, int> m_nameIds;
+    QVector<Event> m_events;
+    QVector<Stats> m_stats;
+    qint64 m_lastFrameEnd;
+    double m_frameInterval;
+    QRect m_hudRect;
+};
+
+#if defined(FLAMESHOT_PROFILE_CAPTURE)
+#define CAPTURE_PROFILE_CONCAT_(a, b) a##b
+#define CAPTURE_PROFILE_CONCAT(a, b) CAPTURE_PROFILE_CONCAT_(a, b)
+#define CAPTURE_PROFILE_SCOPE(name)                                            \
+    CaptureProfiler::Scope CAPTURE_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define CAPTURE_PROFILE_SCOPE(name)
+#endif
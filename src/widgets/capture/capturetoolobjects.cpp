@@ -2,10 +2,33 @@
 // SPDX-FileCopyrightText: 2021 Yurii Puchkov & Contributors
 
 #include "capturetoolobjects.h"
+#include <algorithm>
+#include <functional>
 
 #define SEARCH_RADIUS_NEAR 3
 #define SEARCH_RADIUS_FAR 5
 #define SEARCH_RADIUS_TEXT_HANDICAP 5
+#define SEARCH_RADIUS_MAX (SEARCH_RADIUS_FAR + SEARCH_RADIUS_TEXT_HANDICAP)
+// Objects may draw slightly outside of their bounding rect (same padding as
+// the update rect of the capture widget)
+#define SEARCH_BOUNDS_PADDING 20
+#define SEARCH_GRID_CELL_SIZE 128
+
+namespace {
+
+int gridCell(int coordinate)
+{
+    // Round towards negative infinity, objects can be partially outside
+    return coordinate >= 0 ? coordinate / SEARCH_GRID_CELL_SIZE
+                           : (coordinate + 1) / SEARCH_GRID_CELL_SIZE - 1;
+}
+
+qint64 gridKey(int column, int row)
+{
+    return (static_cast<qint64>(column) << 32) | static_cast<quint32>(row);
+}
+
+} // namespace
 
 CaptureToolObjects::CaptureToolObjects(QObject* parent)
   : QObject(parent)
@@ -15,7 +38,9 @@ void CaptureToolObjects::append(const QPointer<CaptureTool>& captureTool)
 {
     if (!captureTool.isNull()) {
         m_captureToolObjects.append(captureTool->copy(captureTool->parent()));
-        m_imageCache.clear();
+        const int index = m_captureToolObjects.size() - 1;
+        m_bounds.append(searchRect(index));
+        addToGrid(index);
     }
 }
 
@@ -26,7 +51,9 @@ void CaptureToolObjects::insert(int index,
         index <= m_captureToolObjects.size()) {
         m_captureToolObjects.insert(index,
                                     captureTool->copy(captureTool->parent()));
-        m_imageCache.clear();
+        shiftGrid(index, 1);
+        m_bounds.insert(index, searchRect(index));
+        addToGrid(index);
     }
 }
 
@@ -41,6 +68,9 @@ QPointer<CaptureTool> CaptureToolObjects::at(int index)
 void CaptureToolObjects::clear()
 {
     m_captureToolObjects.clear();
+    m_bounds.clear();
+    m_grid.clear();
+    m_staleBounds.clear();
 }
 
 QList<QPointer<CaptureTool>> CaptureToolObjects::captureToolObjects()
@@ -56,8 +86,48 @@ int CaptureToolObjects::size()
 void CaptureToolObjects::removeAt(int index)
 {
     if (index >= 0 && index < m_captureToolObjects.size()) {
+        removeFromGrid(index);
+        m_staleBounds.remove(index);
+        m_bounds.removeAt(index);
         m_captureToolObjects.removeAt(index);
-        m_imageCache.clear();
+        shiftGrid(index + 1, -1);
+    }
+}
+
+void CaptureToolObjects::replace(int index,
+                                 const QPointer<CaptureTool>& captureTool)
+{
+    if (!captureTool.isNull() && index >= 0 &&
+        index < m_captureToolObjects.size()) {
+        removeFromGrid(index);
+        m_staleBounds.remove(index);
+        m_captureToolObjects[index] = captureTool->copy(captureTool->parent());
+        m_bounds[index] = searchRect(index);
+        addToGrid(index);
+    }
+}
+
+// Unlike insert(), the object itself is moved and not copied
+void CaptureToolObjects::move(int from, int to)
+{
+    const int count = m_captureToolObjects.size();
+    if (from == to || from < 0 || from >= count || to < 0 || to >= count) {
+        return;
+    }
+    removeFromGrid(from);
+    m_staleBounds.remove(from);
+    m_bounds.removeAt(from);
+    shiftGrid(from + 1, -1);
+    m_captureToolObjects.move(from, to);
+    shiftGrid(to, 1);
+    m_bounds.insert(to, searchRect(to));
+    addToGrid(to);
+}
+
+void CaptureToolObjects::updateBounds(int index)
+{
+    if (index >= 0 && index < m_captureToolObjects.size()) {
+        m_staleBounds.insert(index);
     }
 }
 
@@ -66,50 +136,44 @@ int CaptureToolObjects::find(const QPoint& pos, QSize captureSize)
     if (m_captureToolObjects.empty()) {
         return -1;
     }
-    QPixmap pixmap(captureSize);
-    pixmap.fill(Qt::transparent);
-    QPainter painter(&pixmap);
+    refreshStaleBounds();
+    auto cell = m_grid.constFind(gridKey(gridCell(pos.x()), gridCell(pos.y())));
+    if (cell == m_grid.constEnd()) {
+        return -1;
+    }
+    // Only the objects close enough to the position are tested, the top most
+    // object first
+    QVector<int> candidates;
+    for (int index : *cell) {
+        if (m_bounds.at(index).contains(pos)) {
+            candidates.append(index);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), std::greater<int>());
+
+    QVector<QImage> images(candidates.size());
+    const QRect captureRect(QPoint(0, 0), captureSize);
     // first attempt to find at exact position
-    int radius = SEARCH_RADIUS_NEAR;
-    int index = findWithRadius(painter, pixmap, pos, radius);
+    int index = findWithRadius(
+      candidates, images, pos, captureRect, SEARCH_RADIUS_NEAR);
     if (-1 == index) {
         // second attempt to find at position with radius
-        radius = SEARCH_RADIUS_FAR;
-        pixmap.fill(Qt::transparent);
-        index = findWithRadius(painter, pixmap, pos, radius);
+        index = findWithRadius(
+          candidates, images, pos, captureRect, SEARCH_RADIUS_FAR);
     }
     return index;
 }
 
-int CaptureToolObjects::findWithRadius(QPainter& painter,
-                                       QPixmap& pixmap,
+int CaptureToolObjects::findWithRadius(const QVector<int>& candidates,
+                                       QVector<QImage>& images,
                                        const QPoint& pos,
+                                       const QRect& captureRect,
                                        int radius)
 {
-    int index = m_captureToolObjects.size() - 1;
-    bool useCache = true;
-    m_imageCache.clear();
-    if (m_imageCache.size() != m_captureToolObjects.size() && index >= 0) {
-        // TODO - is not optimal and cache will be used just after first tool
-        // object selecting
-        m_imageCache.clear();
-        useCache = false;
-    }
-    for (; index >= 0; --index) {
+    for (int i = 0; i < candidates.size(); ++i) {
+        const int index = candidates.at(i);
         int currentRadius = radius;
-        QImage image;
         auto toolItem = m_captureToolObjects.at(index);
-        if (useCache) {
-            image = m_imageCache.at(index);
-        } else {
-            // create transparent image in memory and draw toolItem on it
-            toolItem->drawSearchArea(painter, pixmap);
-
-            // get color at mouse clicked position in area +/- currentRadius
-            image = pixmap.toImage();
-            m_imageCache.insert(0, image);
-        }
-
         if (toolItem->type() == CaptureTool::TYPE_TEXT) {
             if (currentRadius > SEARCH_RADIUS_NEAR) {
                 // Text already has a big currentRadius and no need to search
@@ -123,11 +187,21 @@ int CaptureToolObjects::findWithRadius(QPainter& painter,
             currentRadius += SEARCH_RADIUS_TEXT_HANDICAP;
         }
 
+        // The search area is drawn once and reused by the second attempt
+        if (images.at(i).isNull()) {
+            images[i] = searchImage(index, pos);
+        }
+        const QImage& image = images.at(i);
+
         for (int x = pos.x() - currentRadius; x <= pos.x() + currentRadius;
              ++x) {
             for (int y = pos.y() - currentRadius; y <= pos.y() + currentRadius;
                  ++y) {
-                QRgb rgb = image.pixel(x, y);
+                if (!captureRect.contains(x, y)) {
+                    continue;
+                }
+                QRgb rgb = image.pixel(x - pos.x() + SEARCH_RADIUS_MAX,
+                                       y - pos.y() + SEARCH_RADIUS_MAX);
                 if (rgb != 0) {
                     // object was found, return it index (layer index)
                     return index;
@@ -139,6 +213,114 @@ int CaptureToolObjects::findWithRadius(QPainter& painter,
     return -1;
 }
 
+// Draw the search area of the object in a small transparent image centered on
+// `pos`, large enough for the biggest search radius
+QImage CaptureToolObjects::searchImage(int index, const QPoint& pos)
+{
+    const int side = 2 * SEARCH_RADIUS_MAX + 1;
+    QImage image(side, side, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    painter.translate(SEARCH_RADIUS_MAX - pos.x(), SEARCH_RADIUS_MAX - pos.y());
+    // the search area doesn't depend on the pixels beneath the object
+    m_captureToolObjects.at(index)->drawSearchArea(painter, TiledPixmap());
+    return image;
+}
+
+QRect CaptureToolObjects::searchRect(int index) const
+{
+    const QPointer<CaptureTool>& toolItem = m_captureToolObjects.at(index);
+    if (toolItem.isNull()) {
+        return {};
+    }
+    QRect rect = toolItem->boundingRect().normalized();
+    if (rect.isNull()) {
+        return {};
+    }
+    const int padding = SEARCH_BOUNDS_PADDING + SEARCH_RADIUS_MAX;
+    return rect + QMargins(padding, padding, padding, padding);
+}
+
+void CaptureToolObjects::addToGrid(int index)
+{
+    const QRect& rect = m_bounds.at(index);
+    if (rect.isEmpty()) {
+        return;
+    }
+    for (int row = gridCell(rect.top()); row <= gridCell(rect.bottom());
+         ++row) {
+        for (int column = gridCell(rect.left());
+             column <= gridCell(rect.right());
+             ++column) {
+            m_grid[gridKey(column, row)].append(index);
+        }
+    }
+}
+
+void CaptureToolObjects::removeFromGrid(int index)
+{
+    const QRect& rect = m_bounds.at(index);
+    if (rect.isEmpty()) {
+        return;
+    }
+    for (int row = gridCell(rect.top()); row <= gridCell(rect.bottom());
+         ++row) {
+        for (int column = gridCell(rect.left());
+             column <= gridCell(rect.right());
+             ++column) {
+            auto cell = m_grid.find(gridKey(column, row));
+            if (cell == m_grid.end()) {
+                continue;
+            }
+            cell->removeOne(index);
+            if (cell->isEmpty()) {
+                m_grid.erase(cell);
+            }
+        }
+    }
+}
+
+// Add `offset` to all the indexes starting from `from`
+void CaptureToolObjects::shiftGrid(int from, int offset)
+{
+    for (auto& cell : m_grid) {
+        for (int& index : cell) {
+            if (index >= from) {
+                index += offset;
+            }
+        }
+    }
+    QSet<int> staleBounds;
+    for (int index : qAsConst(m_staleBounds)) {
+        staleBounds.insert(index >= from ? index + offset : index);
+    }
+    m_staleBounds = staleBounds;
+}
+
+void CaptureToolObjects::rebuildGrid()
+{
+    m_bounds.clear();
+    m_grid.clear();
+    m_staleBounds.clear();
+    for (int index = 0; index < m_captureToolObjects.size(); ++index) {
+        m_bounds.append(searchRect(index));
+        addToGrid(index);
+    }
+}
+
+void CaptureToolObjects::refreshStaleBounds()
+{
+    for (int index : qAsConst(m_staleBounds)) {
+        if (index < 0 || index >= m_captureToolObjects.size()) {
+            continue;
+        }
+        removeFromGrid(index);
+        m_bounds[index] = searchRect(index);
+        addToGrid(index);
+    }
+    m_staleBounds.clear();
+}
+
 CaptureToolObjects& CaptureToolObjects::operator=(
   const CaptureToolObjects& other)
 {
@@ -158,5 +340,6 @@ CaptureToolObjects& CaptureToolObjects::operator=(
         }
         count++;
     }
+    rebuildGrid();
     return *this;
 }
@@ -5,8 +5,10 @@
 #define FLAMESHOT_CAPTURETOOLOBJECTS_H
 
 #include "src/tools/capturetool.h"
+#include <QHash>
 #include <QList>
 #include <QPointer>
+#include <QSet>
 
 class CaptureToolObjects : public QObject
 {
@@ -16,21 +18,38 @@ public:
     void append(const QPointer<CaptureTool>& captureTool);
     void insert(int index, const QPointer<CaptureTool>& captureTool);
     void removeAt(int index);
+    void replace(int index, const QPointer<CaptureTool>& captureTool);
+    void move(int from, int to);
     void clear();
     int size();
     int find(const QPoint& pos, QSize captureSize);
+    // The object at `index` was modified in place (moved, resized, ...), its
+    // position in the search index is updated on the next find()
+    void updateBounds(int index);
     QPointer<CaptureTool> at(int index);
     CaptureToolObjects& operator=(const CaptureToolObjects& other);
 
 private:
-    int findWithRadius(QPainter& painter,
-                       QPixmap& pixmap,
+    int findWithRadius(const QVector<int>& candidates,
+                       QVector<QImage>& images,
                        const QPoint& pos,
-                       int radius = 0);
+                       const QRect& captureRect,
+                       int radius);
+    QImage searchImage(int index, const QPoint& pos);
+
+    // Uniform grid indexing the objects by their bounding rect
+    QRect searchRect(int index) const;
+    void addToGrid(int index);
+    void removeFromGrid(int index);
+    void shiftGrid(int from, int offset);
+    void rebuildGrid();
+    void refreshStaleBounds();
 
     // class members
     QList<QPointer<CaptureTool>> m_captureToolObjects;
-    QVector<QImage> m_imageCache;
+    QVector<QRect> m_bounds;
+    QHash<qint64, QVector<int>> m_grid;
+    QSet<int> m_staleBounds;
 };
 
 #endif // FLAMESHOT_CAPTURETOOLOBJECTS_H
@@ -11,6 +11,7 @@
 
 #include "capturewidget.h"
 #include "abstractlogger.h"
+#include "captureprofiler.h"
 #include "copytool.h"
 #include "src/config/cacheutils.h"
 #include "src/config/generalconf.h"
@@ -33,9 +34,11 @@
 #include <QDateTime>
 #include <QDebug>
 #include <QDesktopWidget>
+#include <QDir>
 #include <QFontMetrics>
 #include <QLabel>
 #include <QPaintEvent>
+#include <QScopedPointer>
 #include <QPainter>
 #include <QScreen>
 #include <QShortcut>
@@ -47,6 +50,10 @@
 #endif
 
 #define MOUSE_DISTANCE_TO_START_MOVING 3
+// Width of the outline of the window under the cursor
+#define HOVERED_WINDOW_PEN 2
+// Refresh interval of the profiling HUD in milliseconds
+#define PROFILER_HUD_INTERVAL 500
 
 // CaptureWidget is the main component used to capture the screen. It contains
 // an area of selection with its respective buttons.
@@ -82,7 +89,8 @@ CaptureWidget::CaptureWidget(const CaptureRequest& req,
   , m_startMove(false)
 
 {
-    m_undoStack.setUndoLimit(ConfigHandler().undoLimit());
+    m_undoStack.setLimits(ConfigHandler().undoLimit(),
+                          ConfigHandler().undoMemoryLimit() * 1024LL * 1024);
     m_context.circleCount = 1;
 
     // Base config of the widget
@@ -98,6 +106,13 @@ CaptureWidget::CaptureWidget(const CaptureRequest& req,
     connect(&m_xywhTimer, &QTimer::timeout, this, &CaptureWidget::xywhTick);
     // else xywhTick keeps triggering when not needed
     m_xywhTimer.setSingleShot(true);
+#if defined(FLAMESHOT_PROFILE_CAPTURE)
+    auto* profilerTimer = new QTimer(this);
+    connect(profilerTimer, &QTimer::timeout, this, [this]() {
+        update(CaptureProfiler::instance()->hudRect());
+    });
+    profilerTimer->start(PROFILER_HUD_INTERVAL);
+#endif
     setAttribute(Qt::WA_DeleteOnClose);
     setAttribute(Qt::WA_QuitOnClose, false);
     m_opacity = m_config.contrastOpacity();
@@ -110,14 +125,26 @@ CaptureWidget::CaptureWidget(const CaptureRequest& req,
     QPoint topLeft(0, 0);
 #endif
     if (fullScreen) {
-        // Grab Screenshot
+        // Grab Screenshot, unless the request brings one
         bool ok = true;
-        m_context.screenshot = ScreenGrabber().grabEntireDesktop(ok);
+        m_context.origScreenshot =
+          TiledPixmap(req.screenshot().isNull()
+                        ? ScreenGrabber().grabEntireDesktop(ok)
+                        : req.screenshot());
         if (!ok) {
             AbstractLogger::error() << tr("Unable to capture screen");
             this->close();
         }
-        m_context.origScreenshot = m_context.screenshot;
+        m_context.screenshot = m_context.origScreenshot;
+        m_compositor.setTarget(&m_context.screenshot);
+        m_compositor.setBase(m_context.origScreenshot);
+        // The windows are only known for a live capture of an X11 desktop
+        m_snapToWindows =
+          m_config.snapToWindows() && req.screenshot().isNull() &&
+          QGuiApplication::platformName() == QLatin1String("xcb");
+        if (m_snapToWindows) {
+            m_windowIndex.load();
+        }
 
 #if defined(Q_OS_WIN)
 // Call cmake with -DFLAMESHOT_DEBUG_CAPTURE=ON to enable easier debugging
@@ -293,6 +320,21 @@ CaptureWidget::~CaptureWidget()
     } else {
         emit Flameshot::instance()->captureFailed();
     }
+#if defined(FLAMESHOT_PROFILE_CAPTURE)
+    CaptureProfiler* profiler = CaptureProfiler::instance();
+    QString tracePath =
+      QDir::temp().filePath(QStringLiteral("flameshot-capture-%1.json")
+                              .arg(QDateTime::currentDateTime().toString(
+                                "yyyyMMdd-hhmmss")));
+    if (profiler->writeChromeTrace(tracePath)) {
+        AbstractLogger::info(AbstractLogger::Stderr)
+          << tr("Capture trace saved to %1").arg(tracePath);
+    } else {
+        AbstractLogger::error(AbstractLogger::Stderr)
+          << tr("Unable to save the capture trace to %1").arg(tracePath);
+    }
+    profiler->clear();
+#endif
 }
 
 void CaptureWidget::initButtons()
@@ -401,7 +443,7 @@ void CaptureWidget::handleButtonLeftClick(CaptureToolButton* b)
 void CaptureWidget::xywhTick()
 {
     m_xywhDisplay = false;
-    update();
+    update(m_xywhRect);
 }
 
 void CaptureWidget::onDisplayGridChanged(bool display)
@@ -419,7 +461,17 @@ void CaptureWidget::onGridSizeChanged(int size)
 void CaptureWidget::showxywh()
 {
     m_xywhDisplay = true;
-    update();
+    if (m_xywhRect.isNull()) {
+        // The size of the box is known once it is painted
+        update();
+    } else {
+        // The box is anchored to the selection, so it stays inside the
+        // selection extended by the size of the box
+        const QSize box = m_xywhRect.size();
+        update(m_xywhRect);
+        update(m_selection->geometry().normalized() +
+               QMargins(box.width(), box.height(), box.width(), box.height()));
+    }
     int timeout = m_config.showSelectionGeometryHideTime();
     if (timeout != 0) {
         m_xywhTimer.start(timeout);
@@ -463,6 +515,7 @@ bool CaptureWidget::commitCurrentTool()
 {
     if (m_activeTool) {
         processPixmapWithTool(&m_context.screenshot, m_activeTool);
+        m_compositor.invalidateRect(m_activeTool->boundingRect());
         if (m_activeTool->isValid() && !m_activeTool->editMode() &&
             m_toolWidget) {
             pushToolToStack();
@@ -505,9 +558,15 @@ void CaptureWidget::releaseActiveTool()
         if (m_activeTool->editMode()) {
             // Object shouldn't be deleted here because it is in the undo/redo
             // stack, just set current pointer to null
+            const int index = toolObjectIndex(m_activeTool);
             m_activeTool->setEditMode(false);
             if (m_activeTool->isChanged()) {
+                invalidateToolObject(index, m_activeTool->boundingRect());
                 pushObjectsStateToUndoStack();
+            } else {
+                // The object is only shown again
+                m_compositor.invalidateLayer(index,
+                                             m_activeTool->boundingRect());
             }
         } else {
             delete m_activeTool;
@@ -535,7 +594,10 @@ void CaptureWidget::uncheckActiveTool()
 
 void CaptureWidget::paintEvent(QPaintEvent* paintEvent)
 {
-    Q_UNUSED(paintEvent)
+#if defined(FLAMESHOT_PROFILE_CAPTURE)
+    CaptureProfiler::instance()->newFrame();
+#endif
+    CAPTURE_PROFILE_SCOPE(QStringLiteral("paintEvent"));
     QPainter painter(this);
     GeneralConf::xywh_position position =
       static_cast<GeneralConf::xywh_position>(m_config.showSelectionGeometry());
@@ -555,8 +617,21 @@ void CaptureWidget::paintEvent(QPaintEvent* paintEvent)
         painter.save();
         save = true;
     }
-    painter.drawPixmap(0, 0, m_context.screenshot);
+    {
+        CAPTURE_PROFILE_SCOPE(QStringLiteral("paint: screenshot"));
+        m_context.screenshot.draw(painter, paintEvent->region());
+    }
+    // The tool being drawn is painted before the overlays, the invert tool
+    // inverts whatever is already painted in its area
+    if (m_activeTool && m_mouseIsClicked) {
+        CAPTURE_PROFILE_SCOPE("paint: active tool " + m_activeTool->name());
+        m_activeTool->process(painter, m_context.screenshot);
+    } else if (m_previewEnabled && activeButtonTool() &&
+               m_activeButton->tool()->showMousePreview()) {
+        m_activeButton->tool()->paintMousePreview(painter, m_context);
+    }
     if (m_selection && m_xywhDisplay) {
+        CAPTURE_PROFILE_SCOPE(QStringLiteral("paint: xywh box"));
         const QRect& selection = m_selection->geometry().normalized();
         const qreal scale = m_context.screenshot.devicePixelRatio();
         QRect xybox;
@@ -601,6 +676,7 @@ void CaptureWidget::paintEvent(QPaintEvent* paintEvent)
                   selection.top() + (selection.height() - xybox.height()) / 2;
         }
 
+        m_xywhRect = QRect(x0, y0, xybox.width(), xybox.height());
         QColor uicolor = ConfigHandler().uiColor();
         uicolor.setAlpha(200);
         painter.fillRect(
@@ -616,6 +692,7 @@ void CaptureWidget::paintEvent(QPaintEvent* paintEvent)
     }
 
     if (m_displayGrid) {
+        CAPTURE_PROFILE_SCOPE(QStringLiteral("paint: grid"));
         QColor uicolor = ConfigHandler().uiColor();
         uicolor.setAlpha(100);
         painter.setPen(uicolor);
@@ -630,24 +707,44 @@ void CaptureWidget::paintEvent(QPaintEvent* paintEvent)
         const auto step{ m_gridSize * scale };
         const auto radius{ 1 * scale };
 
-        for (int y = topLeft.y(); y < m_context.selection.bottom(); y += step) {
-            for (int x = topLeft.x(); x < m_context.selection.right();
+        // Only the dots inside the exposed area are drawn
+        const QRect exposed = paintEvent->rect();
+        const int firstRow = qMax(
+          0, static_cast<int>((exposed.top() - radius - topLeft.y()) / step));
+        const int firstColumn = qMax(
+          0, static_cast<int>((exposed.left() - radius - topLeft.x()) / step));
+        const int bottom =
+          qMin(m_context.selection.bottom(), exposed.bottom() + 1);
+        const int right =
+          qMin(m_context.selection.right(), exposed.right() + 1);
+        for (int y = topLeft.y() + firstRow * step; y < bottom; y += step) {
+            for (int x = topLeft.x() + firstColumn * step; x < right;
                  x += step) {
                 painter.drawEllipse(x, y, radius, radius);
             }
         }
     }
 
-    if (m_activeTool && m_mouseIsClicked) {
-        m_activeTool->process(painter, m_context.screenshot);
-    } else if (m_previewEnabled && activeButtonTool() &&
-               m_activeButton->tool()->showMousePreview()) {
-        m_activeButton->tool()->paintMousePreview(painter, m_context);
-    }
     if (save)
         painter.restore();
     // draw inactive region
-    drawInactiveRegion(&painter);
+    {
+        CAPTURE_PROFILE_SCOPE(QStringLiteral("paint: inactive region"));
+        drawInactiveRegion(&painter, paintEvent->region());
+    }
+
+    if (!m_hoveredWindow.isNull() && !m_selection->isVisible()) {
+        // The window that a click selects is not dimmed. The screenshot is
+        // drawn by whole tiles, which must not undim around the window.
+        painter.save();
+        painter.setClipRect(m_hoveredWindow);
+        m_context.screenshot.draw(
+          painter, paintEvent->region().intersected(m_hoveredWindow));
+        painter.restore();
+        painter.setPen(QPen(m_uiColor, HOVERED_WINDOW_PEN));
+        painter.setBrush(Qt::NoBrush);
+        painter.drawRect(m_hoveredWindow.adjusted(1, 1, -1, -1));
+    }
 
     if (!isActiveWindow()) {
         drawErrorMessage(
@@ -661,6 +758,9 @@ void CaptureWidget::paintEvent(QPaintEvent* paintEvent)
                             "gui` again to apply it."),
                          &painter);
     }
+#if defined(FLAMESHOT_PROFILE_CAPTURE)
+    CaptureProfiler::instance()->drawHud(painter);
+#endif
 }
 
 void CaptureWidget::showColorPicker(const QPoint& pos)
@@ -671,11 +771,6 @@ void CaptureWidget::showColorPicker(const QPoint& pos)
         selectToolItemAtPos(pos);
     }
 
-    // save current state for undo/redo stack
-    if (m_panel->activeLayerIndex() >= 0) {
-        m_captureToolObjectsBackup = m_captureToolObjects;
-    }
-
     // Call color picker
     m_colorPicker->move(pos.x() - m_colorPicker->width() / 2,
                         pos.y() - m_colorPicker->height() / 2);
@@ -720,9 +815,12 @@ bool CaptureWidget::startDrawObjectTool(const QPoint& pos)
 
 void CaptureWidget::pushObjectsStateToUndoStack()
 {
-    m_undoStack.push(new ModificationCommand(
-      this, m_captureToolObjects, m_captureToolObjectsBackup));
-    m_captureToolObjectsBackup.clear();
+    flushModifiedToolObjects();
+    if (m_pendingOperations.isEmpty()) {
+        return;
+    }
+    m_undoStack.push(new ModificationCommand(this, m_pendingOperations));
+    m_pendingOperations.clear();
 }
 
 int CaptureWidget::selectToolItemAtPos(const QPoint& pos)
@@ -773,6 +871,9 @@ void CaptureWidget::mousePressEvent(QMouseEvent* e)
         return;
     } else if (e->button() == Qt::LeftButton) {
         m_mouseIsClicked = true;
+        // A click without a drag selects the window under the cursor
+        m_snapOnRelease = !m_hoveredWindow.isNull() && !m_activeButton &&
+                          !m_selection->isVisible();
 
         // Click using a tool excluding tool MOVE
         if (startDrawObjectTool(m_mousePressedPos)) {
@@ -805,8 +906,10 @@ void CaptureWidget::mouseDoubleClickEvent(QMouseEvent* event)
             m_activeTool = activeTool;
             m_mouseIsClicked = false;
             m_context.mousePos = *m_activeTool->pos();
-            m_captureToolObjectsBackup = m_captureToolObjects;
             m_activeTool->setEditMode(true);
+            // The object is hidden while it is edited
+            m_compositor.invalidateLayer(activeLayerIndex,
+                                         m_activeTool->boundingRect());
             drawToolsData();
             updateLayersPanel();
             handleToolSignal(CaptureTool::REQ_ADD_CHILD_WIDGET);
@@ -828,6 +931,7 @@ void CaptureWidget::mouseDoubleClickEvent(QMouseEvent* event)
 
 void CaptureWidget::mouseMoveEvent(QMouseEvent* e)
 {
+    CAPTURE_PROFILE_SCOPE(QStringLiteral("mouseMoveEvent"));
     if (m_magnifier) {
         if (!m_activeButton) {
             m_magnifier->show();
@@ -838,6 +942,9 @@ void CaptureWidget::mouseMoveEvent(QMouseEvent* e)
     }
 
     m_context.mousePos = e->pos();
+    if (m_snapToWindows) {
+        updateHoveredWindow(e->pos());
+    }
     if (e->buttons() != Qt::LeftButton) {
         updateTool(activeButtonTool());
         updateCursor();
@@ -865,15 +972,11 @@ void CaptureWidget::mouseMoveEvent(QMouseEvent* e)
                 m_activeToolOffsetToMouseOnStart =
                   e->pos() - *activeTool->pos();
             }
-            if (!m_activeToolIsMoved) {
-                // save state before movement for undo stack
-                m_captureToolObjectsBackup = m_captureToolObjects;
-            }
             m_activeToolIsMoved = true;
-            // update the old region of the selection, margins are added to
-            // ensure selection outline is updated too
-            update(paddedUpdateRect(activeTool->boundingRect()));
+            QRect oldRect = activeTool->boundingRect();
             activeTool->move(e->pos() - m_activeToolOffsetToMouseOnStart);
+            invalidateToolObject(m_panel->activeLayerIndex(),
+                                 oldRect.united(activeTool->boundingRect()));
             drawToolsData();
         }
     } else if (m_activeTool) {
@@ -930,6 +1033,12 @@ void CaptureWidget::mouseReleaseEvent(QMouseEvent* e)
             }
         }
     }
+    if (m_snapOnRelease && e->button() == Qt::LeftButton &&
+        (e->pos() - m_mousePressedPos).manhattanLength() <=
+          MOUSE_DISTANCE_TO_START_MOVING) {
+        selectHoveredWindow();
+    }
+    m_snapOnRelease = false;
     m_mouseIsClicked = false;
     m_activeToolIsMoved = false;
 
@@ -1217,6 +1326,10 @@ void CaptureWidget::initSelection()
 {
     // Be mindful of the order of statements, so that slots are called properly
     m_selection = new SelectionWidget(m_uiColor, this);
+    if (m_config.magneticSelection()) {
+        m_edgeMap.setSource(m_context.origScreenshot);
+        m_selection->setEdgeMap(&m_edgeMap);
+    }
     QRect initialSelection = m_context.request.initialSelection();
     connect(m_selection, &SelectionWidget::geometryChanged, this, [this]() {
         QRect constrainedToCaptureArea =
@@ -1399,11 +1512,11 @@ void CaptureWidget::onToolSizeChanged(int t)
     auto toolItem = activeToolObject();
     if (toolItem) {
         // Change thickness
+        QRect oldRect = toolItem->boundingRect();
         toolItem->onSizeChanged(t);
-        if (!m_existingObjectIsChanged) {
-            m_captureToolObjectsBackup = m_captureToolObjects;
-            m_existingObjectIsChanged = true;
-        }
+        invalidateToolObject(m_panel->activeLayerIndex(),
+                             oldRect.united(toolItem->boundingRect()));
+        m_existingObjectIsChanged = true;
         drawToolsData();
         updateTool(toolItem);
     }
@@ -1431,6 +1544,8 @@ void CaptureWidget::setDrawColor(const QColor& c)
         if (toolItem) {
             // Change color
             toolItem->onColorChanged(c);
+            invalidateToolObject(m_panel->activeLayerIndex(),
+                                 toolItem->boundingRect());
             drawToolsData();
         }
     }
@@ -1462,21 +1577,25 @@ void CaptureWidget::updateActiveLayer(int layer)
 
 void CaptureWidget::onMoveCaptureToolUp(int captureToolIndex)
 {
-    m_captureToolObjectsBackup = m_captureToolObjects;
+    if (captureToolIndex < 1 ||
+        captureToolIndex >= m_captureToolObjects.size()) {
+        return;
+    }
+    moveToolObject(captureToolIndex, captureToolIndex - 1);
     pushObjectsStateToUndoStack();
-    auto tool = m_captureToolObjects.at(captureToolIndex);
-    m_captureToolObjects.removeAt(captureToolIndex);
-    m_captureToolObjects.insert(captureToolIndex - 1, tool);
+    drawToolsData(false);
     updateLayersPanel();
 }
 
 void CaptureWidget::onMoveCaptureToolDown(int captureToolIndex)
 {
-    m_captureToolObjectsBackup = m_captureToolObjects;
+    if (captureToolIndex < 0 ||
+        captureToolIndex >= m_captureToolObjects.size() - 1) {
+        return;
+    }
+    moveToolObject(captureToolIndex, captureToolIndex + 1);
     pushObjectsStateToUndoStack();
-    auto tool = m_captureToolObjects.at(captureToolIndex);
-    m_captureToolObjects.removeAt(captureToolIndex);
-    m_captureToolObjects.insert(captureToolIndex + 1, tool);
+    drawToolsData(false);
     updateLayersPanel();
 }
 
@@ -1496,9 +1615,6 @@ void CaptureWidget::removeToolObject(int index)
         // in case this tool is circle counter
         const CaptureTool::Type currentToolType =
           m_captureToolObjects.at(index)->type();
-        m_captureToolObjectsBackup = m_captureToolObjects;
-        update(
-          paddedUpdateRect(m_captureToolObjects.at(index)->boundingRect()));
         if (currentToolType == CaptureTool::TYPE_CIRCLECOUNT) {
             int removedCircleCount = m_captureToolObjects.at(index)->count();
             --m_context.circleCount;
@@ -1511,10 +1627,11 @@ void CaptureWidget::removeToolObject(int index)
                 auto circleTool = m_captureToolObjects.at(cnt);
                 if (circleTool->count() >= removedCircleCount) {
                     circleTool->setCount(circleTool->count() - 1);
+                    invalidateToolObject(cnt, circleTool->boundingRect());
                 }
             }
         }
-        m_captureToolObjects.removeAt(index);
+        removeToolObjectAt(index);
         pushObjectsStateToUndoStack();
         drawToolsData();
         updateLayersPanel();
@@ -1695,8 +1812,7 @@ void CaptureWidget::pushToolToStack()
         // function again on text objects
         m_panel->blockSignals(true);
 
-        m_captureToolObjectsBackup = m_captureToolObjects;
-        m_captureToolObjects.append(m_activeTool);
+        addToolObject(m_activeTool);
         pushObjectsStateToUndoStack();
         releaseActiveTool();
         drawToolsData();
@@ -1709,15 +1825,9 @@ void CaptureWidget::pushToolToStack()
 
 void CaptureWidget::drawToolsData(bool drawSelection)
 {
-    // TODO refactor this for performance. The objects should not all be updated
-    // at once every time
-    QPixmap pixmapItem = m_context.origScreenshot;
-    for (auto toolItem : m_captureToolObjects.captureToolObjects()) {
-        processPixmapWithTool(&pixmapItem, toolItem);
-        update(paddedUpdateRect(toolItem->boundingRect()));
-    }
-
-    m_context.screenshot = pixmapItem;
+    CAPTURE_PROFILE_SCOPE(QStringLiteral("drawToolsData"));
+    // Only the layers touched by the invalidated areas are processed again
+    update(m_compositor.render(m_captureToolObjects.captureToolObjects()));
     if (drawSelection) {
         drawObjectSelection();
     }
@@ -1725,10 +1835,15 @@ void CaptureWidget::drawToolsData(bool drawSelection)
 
 void CaptureWidget::drawObjectSelection()
 {
+    update(m_compositor.clearOverlay());
     auto toolItem = activeToolObject();
     if (toolItem && !toolItem->editMode()) {
-        QPainter painter(&m_context.screenshot);
-        toolItem->drawObjectSelection(painter);
+        QRect selectionRect = paddedUpdateRect(toolItem->boundingRect());
+        m_compositor.saveOverlayArea(selectionRect);
+        m_context.screenshot.paint(selectionRect, [&](QPainter& painter) {
+            toolItem->drawObjectSelection(painter);
+        });
+        update(selectionRect);
         // TODO move this elsewhere
         if (m_context.toolSize != toolItem->size()) {
             m_context.toolSize = toolItem->size();
@@ -1739,11 +1854,146 @@ void CaptureWidget::drawObjectSelection()
     }
 }
 
-void CaptureWidget::processPixmapWithTool(QPixmap* pixmap, CaptureTool* tool)
+void CaptureWidget::invalidateToolObject(int index, const QRect& rect)
+{
+    if (index < 0) {
+        return;
+    }
+    m_compositor.invalidateLayer(index, rect);
+    m_captureToolObjects.updateBounds(index);
+    m_modifiedToolObjects.insert(m_captureToolObjects.at(index));
+}
+
+int CaptureWidget::toolObjectIndex(CaptureTool* tool)
+{
+    auto toolObjects = m_captureToolObjects.captureToolObjects();
+    for (int index = 0; index < toolObjects.size(); ++index) {
+        if (toolObjects.at(index) == tool) {
+            return index;
+        }
+    }
+    return -1;
+}
+
+void CaptureWidget::addToolObject(CaptureTool* tool)
+{
+    flushModifiedToolObjects();
+    m_captureToolObjects.append(tool);
+    const int index = m_captureToolObjects.size() - 1;
+    ToolObjectState state = toolObjectState(m_captureToolObjects.at(index));
+    m_toolObjectStates.append(state);
+    m_pendingOperations.append(
+      { ToolObjectOperation::ADD, index, -1, ToolObjectState(), state });
+    m_compositor.invalidateLayersFrom(index, tool->boundingRect());
+}
+
+void CaptureWidget::removeToolObjectAt(int index)
+{
+    flushModifiedToolObjects();
+    m_compositor.invalidateLayersFrom(
+      index, m_captureToolObjects.at(index)->boundingRect());
+    m_pendingOperations.append({ ToolObjectOperation::REMOVE,
+                                 index,
+                                 -1,
+                                 m_toolObjectStates.at(index),
+                                 ToolObjectState() });
+    m_captureToolObjects.removeAt(index);
+    m_toolObjectStates.removeAt(index);
+}
+
+void CaptureWidget::moveToolObject(int from, int to)
+{
+    flushModifiedToolObjects();
+    m_pendingOperations.append({ ToolObjectOperation::REORDER,
+                                 from,
+                                 to,
+                                 ToolObjectState(),
+                                 ToolObjectState() });
+    moveToolObjectState(from, to);
+}
+
+// Record the objects modified in place since the last call, the previous
+// state of each object is shared with the older operations
+void CaptureWidget::flushModifiedToolObjects()
+{
+    if (m_modifiedToolObjects.isEmpty()) {
+        return;
+    }
+    for (int index = 0; index < m_captureToolObjects.size(); ++index) {
+        CaptureTool* tool = m_captureToolObjects.at(index);
+        if (!m_modifiedToolObjects.contains(tool)) {
+            continue;
+        }
+        ToolObjectState state = toolObjectState(tool);
+        m_pendingOperations.append({ ToolObjectOperation::MODIFY,
+                                     index,
+                                     -1,
+                                     m_toolObjectStates.at(index),
+                                     state });
+        m_toolObjectStates[index] = state;
+    }
+    m_modifiedToolObjects.clear();
+}
+
+ToolObjectState CaptureWidget::toolObjectState(CaptureTool* tool) const
+{
+    // Copies can stay connected to the configuration widget of the original
+    // object (text tool), a copy of the copy never is
+    QScopedPointer<CaptureTool> copy(tool->copy(nullptr));
+    return ToolObjectState(copy->copy(nullptr));
+}
+
+void CaptureWidget::insertToolObjectState(int index,
+                                          const ToolObjectState& state)
+{
+    m_captureToolObjects.insert(index, state.data());
+    m_captureToolObjects.at(index)->setParent(this);
+    m_toolObjectStates.insert(index, state);
+    m_compositor.invalidateLayersFrom(index, state->boundingRect());
+}
+
+void CaptureWidget::removeToolObjectState(int index)
+{
+    m_compositor.invalidateLayersFrom(
+      index, m_captureToolObjects.at(index)->boundingRect());
+    m_captureToolObjects.removeAt(index);
+    m_toolObjectStates.removeAt(index);
+}
+
+void CaptureWidget::replaceToolObjectState(int index,
+                                           const ToolObjectState& state)
+{
+    // The state at the same index only changes the object itself, the layers
+    // beneath it are still valid
+    m_compositor.invalidateLayer(
+      index,
+      m_captureToolObjects.at(index)->boundingRect().united(
+        state->boundingRect()));
+    m_captureToolObjects.replace(index, state.data());
+    m_captureToolObjects.at(index)->setParent(this);
+    m_toolObjectStates[index] = state;
+}
+
+void CaptureWidget::moveToolObjectState(int from, int to)
+{
+    m_compositor.invalidateLayersFrom(
+      qMin(from, to),
+      m_captureToolObjects.at(from)->boundingRect().united(
+        m_captureToolObjects.at(to)->boundingRect()));
+    m_captureToolObjects.move(from, to);
+    m_toolObjectStates.move(from, to);
+}
+
+void CaptureWidget::processPixmapWithTool(TiledPixmap* pixmap,
+                                          CaptureTool* tool)
 {
-    QPainter painter(pixmap);
-    painter.setRenderHint(QPainter::Antialiasing);
-    tool->process(painter, *pixmap);
+    CAPTURE_PROFILE_SCOPE("process: " + tool->name());
+    const TiledPixmap background(*pixmap);
+    pixmap->paint(paddedUpdateRect(tool->boundingRect()),
+                  [&](QPainter& painter) {
+                      painter.setRenderHint(QPainter::Antialiasing);
+                      tool->process(painter, background);
+                  });
 }
 
 CaptureTool* CaptureWidget::activeButtonTool() const
@@ -1823,6 +2073,55 @@ QList<QShortcut*> CaptureWidget::newShortcut(const QKeySequence& key,
     return shortcuts;
 }
 
+/**
+ * @brief The window under `pos`, in the coordinates of the widget. The origin
+ * of the screenshot is the one of the X11 root window.
+ */
+QRect CaptureWidget::windowAt(const QPoint& pos) const
+{
+    const qreal ratio = m_context.screenshot.devicePixelRatio();
+    const QRect window =
+      m_windowIndex.windowAt((QPointF(pos) * ratio).toPoint());
+    if (window.isNull()) {
+        return QRect();
+    }
+    return QRectF(QPointF(window.topLeft()) / ratio,
+                  QSizeF(window.size()) / ratio)
+             .toAlignedRect()
+             .intersected(rect());
+}
+
+void CaptureWidget::updateHoveredWindow(const QPoint& pos)
+{
+    QRect window;
+    if (!m_selection->isVisible() && !m_activeButton) {
+        window = windowAt(pos);
+    }
+    if (window == m_hoveredWindow) {
+        return;
+    }
+    const QMargins margins(HOVERED_WINDOW_PEN,
+                           HOVERED_WINDOW_PEN,
+                           HOVERED_WINDOW_PEN,
+                           HOVERED_WINDOW_PEN);
+    update(m_hoveredWindow + margins);
+    update(window + margins);
+    m_hoveredWindow = window;
+}
+
+void CaptureWidget::selectHoveredWindow()
+{
+    const QRect window = m_hoveredWindow;
+    if (window.isNull()) {
+        return;
+    }
+    m_hoveredWindow = QRect();
+    m_selection->show();
+    m_selection->setGeometry(window);
+    emit m_selection->geometrySettled();
+    update();
+}
+
 void CaptureWidget::togglePanel()
 {
     m_panel->toggle();
@@ -1840,11 +2139,43 @@ void CaptureWidget::childLeave()
     updateTool(activeButtonTool());
 }
 
-void CaptureWidget::setCaptureToolObjects(
-  const CaptureToolObjects& captureToolObjects)
-{
-    // Used for undo/redo
-    m_captureToolObjects = captureToolObjects;
+void CaptureWidget::applyToolObjectOperations(
+  const QVector<ToolObjectOperation>& operations,
+  bool undo)
+{
+    // The objects are replaced by copies of the recorded states, operations
+    // are reverted in the reverse order
+    for (int i = 0; i < operations.size(); ++i) {
+        const ToolObjectOperation& operation =
+          operations.at(undo ? operations.size() - 1 - i : i);
+        switch (operation.type) {
+            case ToolObjectOperation::ADD:
+                if (undo) {
+                    removeToolObjectState(operation.index);
+                } else {
+                    insertToolObjectState(operation.index, operation.after);
+                }
+                break;
+            case ToolObjectOperation::REMOVE:
+                if (undo) {
+                    insertToolObjectState(operation.index, operation.before);
+                } else {
+                    removeToolObjectState(operation.index);
+                }
+                break;
+            case ToolObjectOperation::MODIFY:
+                replaceToolObjectState(
+                  operation.index, undo ? operation.before : operation.after);
+                break;
+            case ToolObjectOperation::REORDER:
+                if (undo) {
+                    moveToolObjectState(operation.toIndex, operation.index);
+                } else {
+                    moveToolObjectState(operation.index, operation.toIndex);
+                }
+                break;
+        }
+    }
     drawToolsData();
     updateLayersPanel();
     drawObjectSelection();
@@ -1858,12 +2189,10 @@ void CaptureWidget::undo()
         // be called
         m_panel->setActiveLayer(-1);
     }
+    // Changes not recorded yet are undone first
+    pushObjectsStateToUndoStack();
 
-    // drawToolsData is called twice to update both previous and new regions
-    // FIXME this is a temporary workaround
-    drawToolsData();
     m_undoStack.undo();
-    drawToolsData();
     updateLayersPanel();
 
     restoreCircleCountState();
@@ -1871,12 +2200,8 @@ void CaptureWidget::undo()
 
 void CaptureWidget::redo()
 {
-    // drawToolsData is called twice to update both previous and new regions
-    // FIXME this is a temporary workaround
-    drawToolsData();
+    pushObjectsStateToUndoStack();
     m_undoStack.redo();
-    drawToolsData();
-    update();
     updateLayersPanel();
 
     restoreCircleCountState();
@@ -1925,17 +2250,22 @@ void CaptureWidget::drawErrorMessage(const QString& msg, QPainter* painter)
     }
 }
 
-void CaptureWidget::drawInactiveRegion(QPainter* painter)
+void CaptureWidget::drawInactiveRegion(QPainter* painter,
+                                       const QRegion& exposed)
 {
-    QColor overlayColor(0, 0, 0, m_opacity);
-    painter->setBrush(overlayColor);
-    QRect r;
+    QRect selection;
     if (m_selection->isVisible()) {
-        r = m_selection->geometry().normalized();
+        selection = m_selection->geometry().normalized();
+    }
+    // The region is only rebuilt when the selection or the widget changes
+    if (selection != m_inactiveSelection || rect() != m_inactiveBounds) {
+        m_inactiveRegion = QRegion(rect()).subtracted(selection);
+        m_inactiveSelection = selection;
+        m_inactiveBounds = rect();
+    }
+    // Plain fills of the exposed rects, no clip region nor outline
+    const QColor overlayColor(0, 0, 0, m_opacity);
+    for (const QRect& r : m_inactiveRegion.intersected(exposed)) {
+        painter->fillRect(r, overlayColor);
     }
-    QRegion grey(rect());
-    grey = grey.subtracted(r);
-
-    painter->setClipRegion(grey);
-    painter->drawRect(-1, -1, rect().width() + 1, rect().height() + 1);
 }
@@ -14,15 +14,20 @@
 #include "buttonhandler.h"
 #include "capturetoolbutton.h"
 #include "capturetoolobjects.h"
+#include "layercompositor.h"
+#include "modificationcommand.h"
+#include "modificationhistory.h"
 #include "src/config/generalconf.h"
 #include "src/tools/capturecontext.h"
 #include "src/tools/capturetool.h"
 #include "src/utils/confighandler.h"
+#include "src/utils/edgemap.h"
+#include "src/utils/windowindex.h"
 #include "src/widgets/capture/magnifierwidget.h"
 #include "src/widgets/capture/selectionwidget.h"
 #include <QPointer>
+#include <QSet>
 #include <QTimer>
-#include <QUndoStack>
 #include <QWidget>
 
 class QLabel;
@@ -52,7 +57,10 @@ public:
     ~CaptureWidget();
 
     QPixmap pixmap();
-    void setCaptureToolObjects(const CaptureToolObjects& captureToolObjects);
+    // Used by undo/redo
+    void applyToolObjectOperations(
+      const QVector<ToolObjectOperation>& operations,
+      bool undo);
 #if !defined(DISABLE_UPDATE_CHECKER)
     void showAppUpdateNotification(const QString& appLatestVersion,
                                    const QString& appLatestUrl);
@@ -129,6 +137,9 @@ private:
     void pushToolToStack();
     void makeChild(QWidget* w);
     void restoreCircleCountState();
+    QRect windowAt(const QPoint& pos) const;
+    void updateHoveredWindow(const QPoint& pos);
+    void selectHoveredWindow();
 
     QList<QShortcut*> newShortcut(const QKeySequence& key,
                                   QWidget* parent,
@@ -140,11 +151,24 @@ private:
     QRect extendedRect(const QRect& r) const;
     QRect paddedUpdateRect(const QRect& r) const;
     void drawErrorMessage(const QString& msg, QPainter* painter);
-    void drawInactiveRegion(QPainter* painter);
+    void drawInactiveRegion(QPainter* painter, const QRegion& exposed);
     void drawToolsData(bool drawSelection = true);
     void drawObjectSelection();
-
-    void processPixmapWithTool(QPixmap* pixmap, CaptureTool* tool);
+    void invalidateToolObject(int index, const QRect& rect);
+    int toolObjectIndex(CaptureTool* tool);
+
+    // Structural changes of m_captureToolObjects, recorded for the undo stack
+    void addToolObject(CaptureTool* tool);
+    void removeToolObjectAt(int index);
+    void moveToolObject(int from, int to);
+    void flushModifiedToolObjects();
+    ToolObjectState toolObjectState(CaptureTool* tool) const;
+    void insertToolObjectState(int index, const ToolObjectState& state);
+    void removeToolObjectState(int index);
+    void replaceToolObjectState(int index, const ToolObjectState& state);
+    void moveToolObjectState(int from, int to);
+
+    void processPixmapWithTool(TiledPixmap* pixmap, CaptureTool* tool);
 
     CaptureTool* activeButtonTool() const;
     CaptureTool::Type activeButtonToolType() const;
@@ -156,6 +180,8 @@ private:
 
     // Context information
     CaptureContext m_context;
+    // Renders m_captureToolObjects into m_context.screenshot
+    LayerCompositor m_compositor;
 
     // Main ui color
     QColor m_uiColor;
@@ -164,6 +190,11 @@ private:
 
     // Outside selection opacity
     int m_opacity;
+    // Area dimmed by drawInactiveRegion, built for the given selection and
+    // widget rect
+    QRegion m_inactiveRegion;
+    QRect m_inactiveSelection;
+    QRect m_inactiveBounds;
     int m_toolSizeByKeyboard;
 
     // utility flags
@@ -202,7 +233,11 @@ private:
 
     QMap<CaptureTool::Type, CaptureTool*> m_tools;
     CaptureToolObjects m_captureToolObjects;
-    CaptureToolObjects m_captureToolObjectsBackup;
+    // Last recorded state of each object of m_captureToolObjects
+    QList<ToolObjectState> m_toolObjectStates;
+    // Operations and modified objects not pushed to the undo stack yet
+    QVector<ToolObjectOperation> m_pendingOperations;
+    QSet<CaptureTool*> m_modifiedToolObjects;
 
     QPoint m_mousePressedPos;
     QPoint m_activeToolOffsetToMouseOnStart;
@@ -210,8 +245,10 @@ private:
     // XYWH display position and timer
     bool m_xywhDisplay;
     QTimer m_xywhTimer;
+    // Last painted XYWH box
+    QRect m_xywhRect;
 
-    QUndoStack m_undoStack;
+    ModificationHistory m_undoStack;
 
     bool m_existingObjectIsChanged;
 
@@ -222,4 +259,13 @@ private:
     // Grid
     bool m_displayGrid{ false };
     int m_gridSize{ 10 };
+
+    // Snapping the selection to the window under the cursor
+    bool m_snapToWindows{ false };
+    bool m_snapOnRelease{ false };
+    WindowIndex m_windowIndex;
+    QRect m_hoveredWindow;
+
+    // Snapping the sides of the selection to the edges of the screenshot
+    EdgeMap m_edgeMap;
 };
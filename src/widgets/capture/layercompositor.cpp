@@ -0,0 +1,282 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "layercompositor.h"
+#include "captureprofiler.h"
+#include <QPainter>
+#include <limits>
+
+// Margin added around the bounding rect of each layer, it covers antialiasing
+// and decorations drawn slightly outside of the bounding rect (same as
+// CaptureWidget::paddedUpdateRect)
+#define LAYER_PADDING 20
+
+// How many times the rendering is repeated when objects grow while being
+// processed (text objects compute their area inside process())
+#define MAX_RENDER_DEPTH 1
+
+LayerCompositor::LayerCompositor(TiledPixmap* target)
+  : m_target(target)
+  , m_firstDirtyLayer(std::numeric_limits<int>::max())
+  , m_firstRestructuredLayer(std::numeric_limits<int>::max())
+  , m_fullRenderPending(true)
+{}
+
+void LayerCompositor::setTarget(TiledPixmap* target)
+{
+    m_target = target;
+    m_overlay = TiledPixmap();
+    m_overlayRect = QRect();
+    invalidateAll();
+}
+
+void LayerCompositor::setBase(const TiledPixmap& base)
+{
+    m_base = base;
+    m_caches.clear();
+    m_overlay = TiledPixmap();
+    m_overlayRect = QRect();
+    invalidateAll();
+}
+
+void LayerCompositor::invalidateLayer(int index, const QRect& rect)
+{
+    markDirty(index, rect);
+}
+
+void LayerCompositor::invalidateLayersFrom(int index, const QRect& rect)
+{
+    markDirty(index, rect);
+    m_firstRestructuredLayer = qMin(m_firstRestructuredLayer, qMax(0, index));
+}
+
+void LayerCompositor::invalidateRect(const QRect& rect)
+{
+    markDirty(std::numeric_limits<int>::max(), rect);
+}
+
+void LayerCompositor::invalidateAll()
+{
+    m_fullRenderPending = true;
+}
+
+QRegion LayerCompositor::render(const QList<QPointer<CaptureTool>>& layers)
+{
+    return render(layers, 0);
+}
+
+QRegion LayerCompositor::render(const QList<QPointer<CaptureTool>>& layers,
+                                int depth)
+{
+    if (m_target == nullptr || m_base.isNull()) {
+        return {};
+    }
+    QRegion repainted(clearOverlay());
+    if (m_fullRenderPending || m_target->size() != m_base.size()) {
+        return repainted.united(renderAll(layers, depth));
+    }
+
+    const int count = layers.size();
+    if (m_caches.size() != count) {
+        m_firstRestructuredLayer =
+          qMin(m_firstRestructuredLayer, qMin(m_caches.size(), count));
+        m_caches.resize(count);
+    }
+    for (int i = qMax(0, m_firstRestructuredLayer); i < count; ++i) {
+        m_caches[i] = LayerCache();
+    }
+
+    QRegion dirty = m_dirtyRegion.intersected(targetRect());
+    const int firstDirty = qMin(m_firstDirtyLayer, count);
+    m_dirtyRegion = QRegion();
+    m_firstDirtyLayer = std::numeric_limits<int>::max();
+    m_firstRestructuredLayer = std::numeric_limits<int>::max();
+    if (dirty.isEmpty()) {
+        return repainted;
+    }
+
+    // Start from the closest layer at or below the first dirty one whose
+    // cache covers the whole dirty region, or from the original screenshot
+    const QRect dirtyBounds = dirty.boundingRect();
+    int start = -1;
+    for (int i = qMin(firstDirty, count - 1); i >= 0; --i) {
+        const LayerCache& cache = m_caches.at(i);
+        if (!cache.below.isNull() && cache.rect.contains(dirtyBounds)) {
+            m_target->restore(cache.below, dirty);
+            start = i;
+            break;
+        }
+    }
+    if (start < 0) {
+        m_target->restore(m_base, dirty);
+        start = 0;
+    }
+
+    int grownLayer = -1;
+    QRect grownRect;
+    for (int i = start; i < count; ++i) {
+        CaptureTool* tool = layers.at(i);
+        if (tool == nullptr) {
+            m_caches[i] = LayerCache();
+            continue;
+        }
+        const QRect rect = layerRect(tool);
+        if (!dirty.intersects(rect)) {
+            continue;
+        }
+        LayerCache& cache = m_caches[i];
+        const QRegion outside = QRegion(rect).subtracted(dirty);
+        if (tool->readsBackground() && !outside.isEmpty()) {
+            // The object reads pixels outside of the dirty region, so it is
+            // redrawn as a whole from the pixels beneath it
+            if (cache.below.isNull() || !cache.rect.contains(rect)) {
+                return repainted.united(renderAll(layers, depth));
+            }
+            m_target->restore(cache.below, outside);
+            dirty += outside;
+        }
+        updateCache(cache, rect, dirty);
+        drawLayer(tool, dirty.intersected(rect));
+
+        const QRect drawnRect = layerRect(tool);
+        if (!QRegion(drawnRect).subtracted(dirty).isEmpty()) {
+            if (grownLayer < 0) {
+                grownLayer = i;
+            }
+            grownRect = grownRect.united(drawnRect);
+        }
+    }
+    repainted += dirty;
+
+    if (grownLayer >= 0 && depth < MAX_RENDER_DEPTH) {
+        invalidateLayer(grownLayer, grownRect);
+        repainted += render(layers, depth + 1);
+    }
+    return repainted;
+}
+
+QRegion LayerCompositor::renderAll(const QList<QPointer<CaptureTool>>& layers,
+                                   int depth)
+{
+    // Only shares the tiles, the layers detach the ones they paint
+    *m_target = m_base;
+    m_caches = QVector<LayerCache>(layers.size());
+    int grownLayer = -1;
+    QRect grownRect;
+    for (int i = 0; i < layers.size(); ++i) {
+        CaptureTool* tool = layers.at(i);
+        if (tool == nullptr) {
+            continue;
+        }
+        const QRect rect = layerRect(tool);
+        if (rect.isEmpty()) {
+            continue;
+        }
+        m_caches[i].rect = rect;
+        m_caches[i].below = m_target->cropped(rect);
+        drawLayer(tool, rect);
+
+        const QRect drawnRect = layerRect(tool);
+        if (!rect.contains(drawnRect)) {
+            if (grownLayer < 0) {
+                grownLayer = i;
+            }
+            grownRect = grownRect.united(drawnRect);
+        }
+    }
+    m_dirtyRegion = QRegion();
+    m_firstDirtyLayer = std::numeric_limits<int>::max();
+    m_firstRestructuredLayer = std::numeric_limits<int>::max();
+    m_fullRenderPending = false;
+
+    QRegion repainted(targetRect());
+    if (grownLayer >= 0 && depth < MAX_RENDER_DEPTH) {
+        invalidateLayer(grownLayer, grownRect);
+        repainted += render(layers, depth + 1);
+    }
+    return repainted;
+}
+
+void LayerCompositor::saveOverlayArea(const QRect& rect)
+{
+    if (m_target == nullptr) {
+        return;
+    }
+    m_overlayRect = rect.intersected(targetRect());
+    if (m_overlayRect.isEmpty()) {
+        m_overlay = TiledPixmap();
+        return;
+    }
+    m_overlay = m_target->cropped(m_overlayRect);
+}
+
+QRect LayerCompositor::clearOverlay()
+{
+    if (m_target == nullptr || m_overlay.isNull()) {
+        return {};
+    }
+    QRect cleared = m_overlayRect;
+    m_target->restore(m_overlay, m_overlayRect);
+    m_overlay = TiledPixmap();
+    m_overlayRect = QRect();
+    return cleared;
+}
+
+QRect LayerCompositor::layerRect(CaptureTool* tool) const
+{
+    QRect rect = tool->boundingRect();
+    if (rect.isNull()) {
+        return {};
+    }
+    rect = rect.normalized() + QMargins(LAYER_PADDING,
+                                        LAYER_PADDING,
+                                        LAYER_PADDING,
+                                        LAYER_PADDING);
+    return rect.intersected(targetRect());
+}
+
+QRect LayerCompositor::targetRect() const
+{
+    return m_target->logicalRect();
+}
+
+void LayerCompositor::markDirty(int index, const QRect& rect)
+{
+    m_firstDirtyLayer = qMin(m_firstDirtyLayer, qMax(0, index));
+    if (!rect.isEmpty()) {
+        m_dirtyRegion += rect.normalized() + QMargins(LAYER_PADDING,
+                                                      LAYER_PADDING,
+                                                      LAYER_PADDING,
+                                                      LAYER_PADDING);
+    }
+}
+
+void LayerCompositor::updateCache(LayerCache& cache,
+                                  const QRect& rect,
+                                  const QRegion& region)
+{
+    if (cache.below.isNull() || cache.rect != rect) {
+        // A new cache is valid only if the whole rect has been rendered
+        if (QRegion(rect).subtracted(region).isEmpty()) {
+            cache.rect = rect;
+            cache.below = m_target->cropped(rect);
+        } else {
+            cache = LayerCache();
+        }
+        return;
+    }
+    // Refresh only the changed part of the existing cache
+    cache.below.restore(*m_target, region.intersected(rect));
+}
+
+void LayerCompositor::drawLayer(CaptureTool* tool, const QRegion& clip)
+{
+    CAPTURE_PROFILE_SCOPE("process: " + tool->name());
+    // The tool is called once per tile, it must read the pixels beneath it
+    // and not the ones painted on the previous tiles
+    const TiledPixmap background(*m_target);
+    m_target->paint(clip, [&](QPainter& painter) {
+        painter.setRenderHint(QPainter::Antialiasing);
+        tool->process(painter, background);
+    });
+}
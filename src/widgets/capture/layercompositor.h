@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include "src/tools/capturetool.h"
+#include "src/utils/tiledpixmap.h"
+#include <QList>
+#include <QPointer>
+#include <QRegion>
+#include <QVector>
+
+/**
+ * @brief Renders the capture tool objects (layers) on top of the original
+ * screenshot incrementally.
+ *
+ * For every layer the compositor keeps the pixels beneath it, i.e. the result
+ * of rendering all the lower layers, restricted to the tiles intersecting the
+ * padded bounding rect of the layer. The tiles are shared with the target
+ * until they are painted, so caching a layer doesn't copy any pixels.
+ *
+ * When layers change, only the dirty region is restored from the nearest
+ * cache and only the layers that intersect that region are processed again,
+ * clipped to it. Editing the top layer therefore costs a single layer instead
+ * of a full redraw.
+ *
+ * The compositor renders into a target owned by the caller
+ * (`CaptureContext::screenshot`). Anything painted into the target outside of
+ * the compositor must be reported with `invalidateRect`, except for overlays
+ * registered with `saveOverlayArea`.
+ */
+class LayerCompositor
+{
+public:
+    explicit LayerCompositor(TiledPixmap* target = nullptr);
+
+    void setTarget(TiledPixmap* target);
+    void setBase(const TiledPixmap& base);
+
+    // The layer at `index` was modified in place, `rect` covers the area it
+    // occupied before and after the modification.
+    void invalidateLayer(int index, const QRect& rect);
+    // Layers starting from `index` may now be different objects (insertion,
+    // removal, reordering or undo/redo).
+    void invalidateLayersFrom(int index, const QRect& rect);
+    // Pixels of the target inside `rect` were painted outside the compositor.
+    void invalidateRect(const QRect& rect);
+    void invalidateAll();
+
+    // Render the pending changes into the target and return the repainted
+    // region in widget coordinates.
+    QRegion render(const QList<QPointer<CaptureTool>>& layers);
+
+    // Backup the target pixels under `rect` before painting an overlay
+    // (object selection outline) that must not become part of the layers.
+    void saveOverlayArea(const QRect& rect);
+    // Restore the pixels under the overlay and return the restored rect.
+    QRect clearOverlay();
+
+private:
+    struct LayerCache
+    {
+        QRect rect;
+        TiledPixmap below;
+    };
+
+    QRegion render(const QList<QPointer<CaptureTool>>& layers, int depth);
+    QRegion renderAll(const QList<QPointer<CaptureTool>>& layers, int depth);
+    QRect layerRect(CaptureTool* tool) const;
+    QRect targetRect() const;
+    void markDirty(int index, const QRect& rect);
+    void updateCache(LayerCache& cache,
+                     const QRect& rect,
+                     const QRegion& region);
+    void drawLayer(CaptureTool* tool, const QRegion& clip);
+
+    // class members
+    TiledPixmap* m_target;
+    TiledPixmap m_base;
+    QVector<LayerCache> m_caches;
+
+    QRegion m_dirtyRegion;
+    int m_firstDirtyLayer;
+    int m_firstRestructuredLayer;
+    bool m_fullRenderPending;
+
+    QRect m_overlayRect;
+    TiledPixmap m_overlay;
+};
@@ -10,7 +10,7 @@
 #include <QPen>
 #include <QPixmap>
 
-MagnifierWidget::MagnifierWidget(const QPixmap& p,
+MagnifierWidget::MagnifierWidget(const TiledPixmap& p,
                                  const QColor& c,
                                  bool isSquare,
                                  QWidget* parent)
@@ -23,14 +23,6 @@ MagnifierWidget::MagnifierWidget(const QPixmap& p,
     setFixedSize(parent->width(), parent->height());
     setAttribute(Qt::WA_TransparentForMouseEvents);
     m_color.setAlpha(130);
-    // add padding for circular magnifier
-    QImage padded(p.width() + 2 * m_magPixels,
-                  p.height() + 2 * m_magPixels,
-                  QImage::Format_ARGB32);
-    padded.fill(Qt::black);
-    QPainter painter(&padded);
-    painter.drawPixmap(m_magPixels, m_magPixels, p);
-    m_paddedScreenshot.convertFromImage(padded);
 }
 void MagnifierWidget::paintEvent(QPaintEvent*)
 {
@@ -51,7 +43,10 @@ void MagnifierWidget::drawMagnifierCircle(QPainter& painter)
 
     int magX = static_cast<int>(x * m_devicePixelRatio - m_magPixels);
     int magY = static_cast<int>(y * m_devicePixelRatio - m_magPixels);
-    QRectF magniRect(magX, magY, m_pixels, m_pixels);
+    // x and y include the padding around the screenshot
+    const QPixmap area = screenshotArea(
+      QRect(magX - m_magPixels, magY - m_magPixels, m_pixels, m_pixels));
+    QRectF magniRect(0, 0, m_pixels, m_pixels);
 
     qreal drawPosX = x + m_magOffset + m_pixels * magZoom / 2;
     if (drawPosX > width() - m_pixels * magZoom / 2) {
@@ -90,8 +85,7 @@ void MagnifierWidget::drawMagnifierCircle(QPainter& painter)
     path.addEllipse(drawPos, m_pixels * magZoom / 2, m_pixels * magZoom / 2);
     painter.setClipPath(path);
 
-    painter.drawPixmapFragments(
-      &frag, 1, m_paddedScreenshot, QPainter::OpaqueHint);
+    painter.drawPixmapFragments(&frag, 1, area, QPainter::OpaqueHint);
     painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
     for (const auto& rect :
          { crossHairTop, crossHairRight, crossHairBottom, crossHairLeft }) {
@@ -135,7 +129,8 @@ void MagnifierWidget::drawMagnifier(QPainter& painter)
             magY = maxY;
         }
     }
-    QRectF magniRect(magX, magY, m_pixels, m_pixels);
+    const QPixmap area = screenshotArea(QRect(magX, magY, m_pixels, m_pixels));
+    QRectF magniRect(0, 0, m_pixels, m_pixels);
 
     qreal drawPosX = x + m_magOffset + m_pixels * magZoom / 2;
     if (drawPosX > width() - m_pixels * magZoom / 2) {
@@ -170,10 +165,27 @@ void MagnifierWidget::drawMagnifier(QPainter& painter)
       QPainter::PixmapFragment::create(drawPos, magniRect, magZoom, magZoom);
 
     painter.fillRect(crossHairBorder, m_borderColor);
-    painter.drawPixmapFragments(&frag, 1, m_screenshot, QPainter::OpaqueHint);
+    painter.drawPixmapFragments(&frag, 1, area, QPainter::OpaqueHint);
     painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
     for (const auto& rect :
          { crossHairTop, crossHairRight, crossHairBottom, crossHairLeft }) {
         painter.fillRect(rect, m_color);
     }
 }
+
+// Copy the pixels of the screenshot inside `rect`, the parts outside of the
+// screenshot are black
+QPixmap MagnifierWidget::screenshotArea(const QRect& rect) const
+{
+    QPixmap area(rect.size());
+    area.fill(Qt::black);
+    const QRect visible = rect.intersected(m_screenshot.rect());
+    if (!visible.isEmpty()) {
+        QPainter painter(&area);
+        painter.drawPixmap(QRect(visible.topLeft() - rect.topLeft(),
+                                 visible.size()),
+                           m_screenshot.copy(visible),
+                           QRect(QPoint(0, 0), visible.size()));
+    }
+    return area;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "src/utils/tiledpixmap.h"
 #include <QWidget>
 
 class QPropertyAnimation;
@@ -8,7 +9,7 @@ class MagnifierWidget : public QWidget
 {
     Q_OBJECT
 public:
-    explicit MagnifierWidget(const QPixmap& p,
+    explicit MagnifierWidget(const TiledPixmap& p,
                              const QColor& c,
                              bool isSquare,
                              QWidget* parent = nullptr);
@@ -25,8 +26,8 @@ private:
     bool m_square;
     QColor m_color;
     QColor m_borderColor;
-    QPixmap m_screenshot;
-    QPixmap m_paddedScreenshot;
+    TiledPixmap m_screenshot;
+    QPixmap screenshotArea(const QRect& rect) const;
     void drawMagnifier(QPainter& painter);
     void drawMagnifierCircle(QPainter& painter);
 };
@@ -6,20 +6,22 @@
 
 ModificationCommand::ModificationCommand(
   CaptureWidget* captureWidget,
-  const CaptureToolObjects& captureToolObjects,
-  const CaptureToolObjects& captureToolObjectsBackup)
-  : m_captureWidget(captureWidget)
-{
-    m_captureToolObjects = captureToolObjects;
-    m_captureToolObjectsBackup = captureToolObjectsBackup;
-}
+  const QVector<ToolObjectOperation>& operations)
+  : m_operations(operations)
+  , m_captureWidget(captureWidget)
+{}
 
 void ModificationCommand::undo()
 {
-    m_captureWidget->setCaptureToolObjects(m_captureToolObjectsBackup);
+    m_captureWidget->applyToolObjectOperations(m_operations, true);
 }
 
 void ModificationCommand::redo()
 {
-    m_captureWidget->setCaptureToolObjects(m_captureToolObjects);
+    m_captureWidget->applyToolObjectOperations(m_operations, false);
+}
+
+const QVector<ToolObjectOperation>& ModificationCommand::operations() const
+{
+    return m_operations;
 }
@@ -1,27 +1,52 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 // SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
 
-#include "capturetoolobjects.h"
-#include <QUndoCommand>
+#include "src/tools/capturetool.h"
+#include <QSharedPointer>
+#include <QVector>
 
 #ifndef FLAMESHOT_MODIFICATIONCOMMAND_H
 #define FLAMESHOT_MODIFICATIONCOMMAND_H
 
 class CaptureWidget;
 
-class ModificationCommand : public QUndoCommand
+// Snapshot of a capture tool object. Snapshots are never modified once
+// created, so the same snapshot is shared by every history entry and by the
+// capture widget as long as the object doesn't change.
+using ToolObjectState = QSharedPointer<CaptureTool>;
+
+struct ToolObjectOperation
+{
+    enum Type
+    {
+        ADD,
+        REMOVE,
+        MODIFY,
+        REORDER
+    };
+
+    Type type;
+    int index;
+    // Destination index of REORDER operations
+    int toIndex;
+    // State before the operation (REMOVE and MODIFY)
+    ToolObjectState before;
+    // State after the operation (ADD and MODIFY)
+    ToolObjectState after;
+};
+
+class ModificationCommand
 {
 public:
     ModificationCommand(CaptureWidget* captureWidget,
-                        const CaptureToolObjects& captureToolObjects,
-                        const CaptureToolObjects& captureToolObjectsBackup);
+                        const QVector<ToolObjectOperation>& operations);
 
-    virtual void undo() override;
-    virtual void redo() override;
+    void undo();
+    void redo();
+    const QVector<ToolObjectOperation>& operations() const;
 
 private:
-    CaptureToolObjects m_captureToolObjects;
-    CaptureToolObjects m_captureToolObjectsBackup;
+    QVector<ToolObjectOperation> m_operations;
     CaptureWidget* m_captureWidget;
 };
 
@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#include "modificationhistory.h"
+#include "modificationcommand.h"
+
+ModificationHistory::ModificationHistory()
+  : m_index(0)
+  , m_countLimit(0)
+  , m_bytesLimit(0)
+  , m_memoryUsage(0)
+{}
+
+ModificationHistory::~ModificationHistory()
+{
+    clear();
+}
+
+void ModificationHistory::setLimits(int count, qint64 bytes)
+{
+    m_countLimit = qMax(0, count);
+    m_bytesLimit = qMax<qint64>(0, bytes);
+    applyLimits();
+}
+
+void ModificationHistory::push(ModificationCommand* command)
+{
+    dropRedoCommands();
+    m_commands.append(command);
+    addSnapshots(command);
+    ++m_index;
+    applyLimits();
+}
+
+void ModificationHistory::undo()
+{
+    if (m_index > 0) {
+        --m_index;
+        m_commands.at(m_index)->undo();
+    }
+}
+
+void ModificationHistory::redo()
+{
+    if (m_index < m_commands.size()) {
+        m_commands.at(m_index)->redo();
+        ++m_index;
+    }
+}
+
+void ModificationHistory::clear()
+{
+    qDeleteAll(m_commands);
+    m_commands.clear();
+    m_index = 0;
+    m_memoryUsage = 0;
+    m_snapshotReferences.clear();
+}
+
+void ModificationHistory::dropRedoCommands()
+{
+    while (m_commands.size() > m_index) {
+        ModificationCommand* command = m_commands.takeLast();
+        removeSnapshots(command);
+        delete command;
+    }
+}
+
+void ModificationHistory::applyLimits()
+{
+    // Only applied commands can be dropped, and the last one is always kept
+    // even if it is over the memory limit
+    while (m_index > 0 && m_commands.size() > 1 &&
+           ((m_countLimit > 0 && m_commands.size() > m_countLimit) ||
+            (m_bytesLimit > 0 && m_memoryUsage > m_bytesLimit))) {
+        ModificationCommand* command = m_commands.takeFirst();
+        removeSnapshots(command);
+        delete command;
+        --m_index;
+    }
+}
+
+void ModificationHistory::addSnapshots(const ModificationCommand* command)
+{
+    for (const auto& operation : command->operations()) {
+        for (const ToolObjectState& state :
+             { operation.before, operation.after }) {
+            if (!state.isNull() && m_snapshotReferences[state.data()]++ == 0) {
+                m_memoryUsage += state->memoryUsage();
+            }
+        }
+    }
+}
+
+void ModificationHistory::removeSnapshots(const ModificationCommand* command)
+{
+    for (const auto& operation : command->operations()) {
+        for (const ToolObjectState& state :
+             { operation.before, operation.after }) {
+            if (state.isNull()) {
+                continue;
+            }
+            auto it = m_snapshotReferences.find(state.data());
+            if (it != m_snapshotReferences.end() && --it.value() == 0) {
+                m_memoryUsage -= state->memoryUsage();
+                m_snapshotReferences.erase(it);
+            }
+        }
+    }
+}
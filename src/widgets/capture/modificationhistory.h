@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// SPDX-FileCopyrightText: 2017-2019 Alejandro Sirgo Rica & Contributors
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+
+class CaptureTool;
+class ModificationCommand;
+
+/**
+ * @brief Undo/redo history of the capture tool objects.
+ *
+ * Unlike QUndoStack, pushing a command doesn't apply it (the modification is
+ * already done when it is recorded), and the history can be limited by the
+ * memory used by the commands as well as by their number. The oldest
+ * commands are dropped first.
+ *
+ * The snapshots are shared between the commands (the state after a command
+ * is the state before a later one), so they are counted by reference: a
+ * snapshot uses memory as long as one of the commands holds it.
+ */
+class ModificationHistory
+{
+public:
+    ModificationHistory();
+    ~ModificationHistory();
+
+    // A limit of 0 means unlimited
+    void setLimits(int count, qint64 bytes);
+    void push(ModificationCommand* command);
+    void undo();
+    void redo();
+    void clear();
+
+private:
+    void dropRedoCommands();
+    void applyLimits();
+    void addSnapshots(const ModificationCommand* command);
+    void removeSnapshots(const ModificationCommand* command);
+
+    // class members
+    QList<ModificationCommand*> m_commands;
+    // Number of commands currently applied
+    int m_index;
+    int m_countLimit;
+    qint64 m_bytesLimit;
+    qint64 m_memoryUsage;
+    // Number of references to every snapshot held by the commands
+    QHash<const CaptureTool*, int> m_snapshotReferences;
+};
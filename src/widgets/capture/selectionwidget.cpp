@@ -4,6 +4,7 @@
 #include "selectionwidget.h"
 #include "capturetool.h"
 #include "capturetoolbutton.h"
+#include "src/utils/edgemap.h"
 #include "src/utils/globalvalues.h"
 #include <QApplication>
 #include <QEvent>
@@ -20,6 +21,7 @@ SelectionWidget::SelectionWidget(QColor c, QWidget* parent)
   , m_color(std::move(c))
   , m_activeSide(NO_SIDE)
   , m_ignoreMouse(false)
+  , m_edgeMap(nullptr)
 {
     // prevents this widget from consuming CaptureToolButton mouse events
     setAttribute(Qt::WA_TransparentForMouseEvents);
@@ -120,6 +122,11 @@ void SelectionWidget::setIdleCentralCursor(const QCursor& cursor)
     m_idleCentralCursor = cursor;
 }
 
+void SelectionWidget::setEdgeMap(EdgeMap* map)
+{
+    m_edgeMap = map;
+}
+
 void SelectionWidget::setGeometryAnimated(const QRect& r)
 {
     if (isVisible()) {
@@ -193,6 +200,9 @@ void SelectionWidget::parentMouseReleaseEvent(QMouseEvent* e)
 void SelectionWidget::parentMouseMoveEvent(QMouseEvent* e)
 {
     updateCursor();
+    if (m_edgeMap != nullptr) {
+        m_edgeMap->prefetch(e->pos());
+    }
 
     if (e->buttons() != Qt::LeftButton) {
         return;
@@ -371,6 +381,9 @@ void SelectionWidget::parentMouseMoveEvent(QMouseEvent* e)
               geom.bottomRight() + deltaBottomRight - deltaTopLeft;
         }
         geom = { newTopLeft, newBottomRight };
+        if (m_edgeMap != nullptr && !symmetryMod && !preserveAspect) {
+            geom = snapToEdges(geom, mouseSide);
+        }
         setGeometry(geom.normalized());
         m_activeSide = getProperSide(m_activeSide, geom);
     }
@@ -442,22 +455,31 @@ void SelectionWidget::moveDown()
 
 void SelectionWidget::resizeLeft()
 {
-    setGeometryByKeyboard(geometry().adjusted(0, 0, -1, 0));
+    QRect r = geometry();
+    r.setRight(nextEdge(Qt::Vertical, r.right(), -1, r.top(), r.bottom()));
+    setGeometryByKeyboard(r);
 }
 
 void SelectionWidget::resizeRight()
 {
-    setGeometryByKeyboard(geometry().adjusted(0, 0, 1, 0));
+    QRect r = geometry();
+    r.setRight(nextEdge(Qt::Vertical, r.right(), 1, r.top(), r.bottom()));
+    setGeometryByKeyboard(r);
 }
 
 void SelectionWidget::resizeUp()
 {
-    setGeometryByKeyboard(geometry().adjusted(0, 0, 0, -1));
+    QRect r = geometry();
+    r.setBottom(
+      nextEdge(Qt::Horizontal, r.bottom(), -1, r.left(), r.right()));
+    setGeometryByKeyboard(r);
 }
 
 void SelectionWidget::resizeDown()
 {
-    setGeometryByKeyboard(geometry().adjusted(0, 0, 0, 1));
+    QRect r = geometry();
+    r.setBottom(nextEdge(Qt::Horizontal, r.bottom(), 1, r.left(), r.right()));
+    setGeometryByKeyboard(r);
 }
 
 void SelectionWidget::symResizeLeft()
@@ -546,6 +568,41 @@ void SelectionWidget::updateCursor()
     }
 }
 
+QRect SelectionWidget::snapToEdges(QRect r, SideType side)
+{
+    // The sides being dragged snap along the span of the selection
+    const QRect span = r.normalized();
+    if (side & LEFT_SIDE) {
+        r.setLeft(m_edgeMap->snap(
+          Qt::Vertical, r.left(), span.top(), span.bottom()));
+    }
+    if (side & RIGHT_SIDE) {
+        r.setRight(m_edgeMap->snap(
+          Qt::Vertical, r.right(), span.top(), span.bottom()));
+    }
+    if (side & TOP_SIDE) {
+        r.setTop(m_edgeMap->snap(
+          Qt::Horizontal, r.top(), span.left(), span.right()));
+    }
+    if (side & BOTTOM_SIDE) {
+        r.setBottom(m_edgeMap->snap(
+          Qt::Horizontal, r.bottom(), span.left(), span.right()));
+    }
+    return r;
+}
+
+int SelectionWidget::nextEdge(Qt::Orientation orientation,
+                              int position,
+                              int step,
+                              int from,
+                              int to)
+{
+    if (m_edgeMap == nullptr) {
+        return position + step;
+    }
+    return m_edgeMap->next(orientation, position, step, from, to);
+}
+
 void SelectionWidget::setGeometryByKeyboard(const QRect& r)
 {
     static QTimer timer;
@@ -5,6 +5,7 @@
 
 #include <QWidget>
 
+class EdgeMap;
 class QPropertyAnimation;
 
 class SelectionWidget : public QWidget
@@ -32,6 +33,8 @@ public:
 
     void setIgnoreMouse(bool ignore);
     void setIdleCentralCursor(const QCursor& cursor);
+    // Snap the sides to the edges of `map` while resizing, nullptr to stop
+    void setEdgeMap(EdgeMap* map);
 
     void setGeometryAnimated(const QRect& r);
     void setGeometry(const QRect& r);
@@ -81,6 +84,12 @@ private:
     void updateAreas();
     void updateCursor();
     void setGeometryByKeyboard(const QRect& r);
+    QRect snapToEdges(QRect r, SideType side);
+    int nextEdge(Qt::Orientation orientation,
+                 int position,
+                 int step,
+                 int from,
+                 int to);
 
     QPropertyAnimation* m_animation;
 
@@ -93,6 +102,7 @@ private:
     QCursor m_idleCentralCursor;
     bool m_ignoreMouse;
     bool m_mouseStartMove;
+    EdgeMap* m_edgeMap;
 
     // naming convention for handles
     // T top, B bottom, R Right, L left
@@ -22,9 +22,12 @@ CaptureLauncher::CaptureLauncher(QDialog* parent)
     ui->setupUi(this);
     setAttribute(Qt::WA_DeleteOnClose);
     setWindowIcon(QIcon(GlobalValues::iconPath()));
-    bool ok;
 
-    ui->imagePreview->setScreenshot(ScreenGrabber().grabEntireDesktop(ok));
+    ScreenGrabber().grabEntireDesktopAsync(
+      QRect(), this, [this](bool ok, const QPixmap& p) {
+          Q_UNUSED(ok)
+          ui->imagePreview->setScreenshot(p);
+      });
     ui->imagePreview->setSizePolicy(QSizePolicy::Expanding,
                                     QSizePolicy::Expanding);
 
@@ -5,6 +5,7 @@
 #include "confighandler.h"
 #include "overlaymessage.h"
 #include "src/core/qguiappcurrentscreen.h"
+#include "src/utils/tiledpixmap.h"
 #include <QApplication>
 #include <QDebug>
 #include <QKeyEvent>
@@ -24,7 +25,7 @@
 // NOTE: WIDTH1(2) should be divisible by ZOOM1(2) for best precision.
 //       WIDTH1 should be odd so the cursor can be centered on a pixel.
 
-ColorGrabWidget::ColorGrabWidget(QPixmap* p, QWidget* parent)
+ColorGrabWidget::ColorGrabWidget(TiledPixmap* p, QWidget* parent)
   : QWidget(parent)
   , m_pixmap(p)
   , m_mousePressReceived(false)
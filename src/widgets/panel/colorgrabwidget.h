@@ -5,12 +5,13 @@
 
 class SidePanelWidget;
 class OverlayMessage;
+class TiledPixmap;
 
 class ColorGrabWidget : public QWidget
 {
     Q_OBJECT
 public:
-    ColorGrabWidget(QPixmap* p, QWidget* parent = nullptr);
+    ColorGrabWidget(TiledPixmap* p, QWidget* parent = nullptr);
 
     void startGrabbing();
 
@@ -33,7 +34,7 @@ private:
     void updateWidget();
     void finalize();
 
-    QPixmap* m_pixmap;
+    TiledPixmap* m_pixmap;
     QImage m_previewImage;
     QColor m_color;
 
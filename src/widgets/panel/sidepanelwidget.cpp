@@ -20,7 +20,7 @@
 #include <QScreen>
 #endif
 
-SidePanelWidget::SidePanelWidget(QPixmap* p, QWidget* parent)
+SidePanelWidget::SidePanelWidget(TiledPixmap* p, QWidget* parent)
   : QWidget(parent)
   , m_layout(new QVBoxLayout(this))
   , m_pixmap(p)
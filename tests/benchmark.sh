@@ -0,0 +1,60 @@
+#!/usr/bin/env sh
+
+# Measures the latency and the memory of the capture pipeline on synthetic
+# desktops, requires a build with -DFLAMESHOT_BENCHMARK=ON
+# Arguments:
+# 1. path to tested flameshot executable
+# 2. output file (default: stdout)
+#
+# Environment:
+# - BENCH_SIZES: desktop sizes (default: "1920x1080 3840x2160 7680x4320")
+# - BENCH_DPRS: device pixel ratios (default: "1 2")
+# - BENCH_ITERATIONS: captures per stage (default: 20)
+# - BENCH_PLATFORM: "xvfb" (default) or "offscreen" for the offscreen Qt
+#   platform, which only has a fake screen
+#
+# Dependencies:
+# - Xvfb
+#
+# Every run prints one JSON object per line (JSON Lines) with the desktop
+# that was used and the p50/p95/mean latency and peak RSS of each stage, so
+# the results of two releases can be compared with jq or a spreadsheet.
+
+FLAMESHOT="$1"
+[ -z "$FLAMESHOT" ] && FLAMESHOT="flameshot"
+OUTPUT="$2"
+[ -z "$OUTPUT" ] && OUTPUT=/dev/stdout
+SIZES="${BENCH_SIZES:-1920x1080 3840x2160 7680x4320}"
+DPRS="${BENCH_DPRS:-1 2}"
+ITERATIONS="${BENCH_ITERATIONS:-20}"
+PLATFORM="${BENCH_PLATFORM:-xvfb}"
+
+# Keep the configuration of the user out of the measures
+XDG_CONFIG_HOME=$(mktemp -d)
+export XDG_CONFIG_HOME
+trap 'rm -rf "$XDG_CONFIG_HOME"' EXIT
+
+# Run the benchmark with the given device pixel ratio
+bench() {
+    QT_SCALE_FACTOR="$1" QT_AUTO_SCREEN_SCALE_FACTOR=0 \
+        "$FLAMESHOT" benchmark "$ITERATIONS" >>"$OUTPUT"
+}
+
+if [ "$PLATFORM" = "offscreen" ]; then
+    for dpr in $DPRS; do
+        QT_QPA_PLATFORM=offscreen bench "$dpr"
+    done
+    exit
+fi
+
+display=:97
+for size in $SIZES; do
+    Xvfb "$display" -screen 0 "${size}x24" -nolisten tcp >/dev/null 2>&1 &
+    xvfb=$!
+    sleep 1
+    for dpr in $DPRS; do
+        DISPLAY="$display" QT_QPA_PLATFORM=xcb bench "$dpr"
+    done
+    kill "$xvfb"
+    wait "$xvfb" 2>/dev/null
+done
@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+
+# Mock of org.freedesktop.portal.Screenshot on the session bus, for
+# portal_screenshot.sh
+# Arguments:
+# 1. width of the screenshots
+# 2. height of the screenshots
+# 3. response code (default: 0, 1 for a cancelled request)
+# 4. delay of the response in ms (default: 0)
+
+# Dependencies:
+# - dbus-python and PyGObject
+
+import os
+import struct
+import sys
+import tempfile
+import zlib
+
+import dbus
+import dbus.lowlevel
+import dbus.service
+from dbus.mainloop.glib import DBusGMainLoop
+from gi.repository import GLib
+
+SERVICE = "org.freedesktop.portal.Desktop"
+PATH = "/org/freedesktop/portal/desktop"
+INTERFACE = "org.freedesktop.portal.Screenshot"
+REQUEST_INTERFACE = "org.freedesktop.portal.Request"
+
+WIDTH = int(sys.argv[1])
+HEIGHT = int(sys.argv[2])
+RESPONSE = int(sys.argv[3]) if len(sys.argv) > 3 else 0
+DELAY = int(sys.argv[4]) if len(sys.argv) > 4 else 0
+
+
+def png(width, height):
+    """An RGB PNG with a gradient, so that a region can be told apart"""
+
+    def chunk(kind, data):
+        body = kind + data
+        return struct.pack(">I", len(data)) + body + struct.pack(
+            ">I", zlib.crc32(body) & 0xFFFFFFFF
+        )
+
+    rows = b"".join(
+        b"\0" + b"".join(bytes((x % 256, y % 256, 128)) for x in range(width))
+        for y in range(height)
+    )
+    header = struct.pack(">IIBBBBB", width, height, 8, 2, 0, 0, 0)
+    return (
+        b"\x89PNG\r\n\x1a\n"
+        + chunk(b"IHDR", header)
+        + chunk(b"IDAT", zlib.compress(rows))
+        + chunk(b"IEND", b"")
+    )
+
+
+class Screenshot(dbus.service.Object):
+    def __init__(self, bus):
+        super().__init__(bus, PATH)
+        self.bus = bus
+
+    @dbus.service.method(
+        INTERFACE,
+        in_signature="sa{sv}",
+        out_signature="o",
+        sender_keyword="sender",
+    )
+    def Screenshot(self, parent_window, options, sender=None):
+        # The handle is predictable, see the documentation of Request
+        handle = "%s/request/%s/%s" % (
+            PATH,
+            sender[1:].replace(".", "_"),
+            options["handle_token"],
+        )
+        GLib.timeout_add(DELAY, self.respond, handle)
+        return dbus.ObjectPath(handle)
+
+    def respond(self, handle):
+        results = {}
+        if RESPONSE == 0:
+            fd, path = tempfile.mkstemp(suffix=".png")
+            with os.fdopen(fd, "wb") as file:
+                file.write(png(WIDTH, HEIGHT))
+            results["uri"] = "file://" + path
+        message = dbus.lowlevel.SignalMessage(
+            handle, REQUEST_INTERFACE, "Response"
+        )
+        message.append(
+            dbus.UInt32(RESPONSE),
+            dbus.Dictionary(results, signature="sv"),
+        )
+        self.bus.send_message(message)
+        return False
+
+
+DBusGMainLoop(set_as_default=True)
+session = dbus.SessionBus()
+name = dbus.service.BusName(SERVICE, session)
+portal = Screenshot(session)
+GLib.MainLoop().run()
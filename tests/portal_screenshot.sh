@@ -0,0 +1,96 @@
+#!/usr/bin/env sh
+
+# Tests captures through xdg-desktop-portal against a mock portal, on a
+# private session bus and without a display
+# Arguments:
+# 1. path to tested flameshot executable
+
+# Dependencies:
+# - dbus-run-session (dbus)
+# - python3 with dbus-python and PyGObject, for mock_portal.py
+
+# HOW TO USE:
+# - Start the script with path to tested flameshot executable as the first
+#   argument, no flameshot daemon needs to run
+# - Each check prints PASS or FAIL, the script fails when one of them fails
+
+FLAMESHOT="$1"
+[ -z "$FLAMESHOT" ] && FLAMESHOT="flameshot"
+
+if [ -z "$MOCK_PORTAL_SESSION" ]; then
+    MOCK_PORTAL_SESSION=1 exec dbus-run-session -- sh "$0" "$FLAMESHOT"
+fi
+
+DIR=$(dirname "$0")
+OUT=$(mktemp)
+FAILED=0
+
+# Run flameshot as on a GNOME Wayland session
+flameshot() {
+    XDG_SESSION_TYPE=wayland XDG_CURRENT_DESKTOP=GNOME \
+        QT_QPA_PLATFORM=offscreen command "$FLAMESHOT" "$@"
+}
+
+# Start the mock portal with the given arguments, stopped by stop_portal
+start_portal() {
+    python3 "$DIR/mock_portal.py" "$@" &
+    PORTAL=$!
+    i=0
+    until dbus-send --session --print-reply --dest=org.freedesktop.DBus \
+        /org/freedesktop/DBus org.freedesktop.DBus.GetNameOwner \
+        string:org.freedesktop.portal.Desktop >/dev/null 2>&1; do
+        i=$((i + 1))
+        if [ "$i" -gt 50 ]; then
+            echo "The mock portal didn't start" >&2
+            exit 1
+        fi
+        sleep 0.1
+    done
+}
+
+stop_portal() {
+    kill "$PORTAL"
+    wait "$PORTAL" 2>/dev/null
+}
+
+# Print the size of the PNG file $1 as WIDTHxHEIGHT
+png_size() {
+    python3 -c 'import struct, sys
+data = open(sys.argv[1], "rb").read(24)
+if data[:8] == b"\x89PNG\r\n\x1a\n":
+    print("%dx%d" % struct.unpack(">II", data[16:24]))' "$1"
+}
+
+# Check that the description $1 holds, from the status of the rest
+check() {
+    description="$1"
+    shift
+    if "$@"; then
+        echo "PASS: $description"
+    else
+        echo "FAIL: $description"
+        FAILED=1
+    fi
+}
+
+start_portal 640 480
+flameshot full --raw >"$OUT"
+check "full capture" test "$(png_size "$OUT")" = "640x480"
+flameshot full --region 100x50+10+20 --raw >"$OUT"
+check "region capture" test "$(png_size "$OUT")" = "100x50"
+stop_portal
+
+# The portal answers after the permission dialog was shown a while
+start_portal 320 200 0 3000
+flameshot full --raw >"$OUT"
+check "slow portal" test "$(png_size "$OUT")" = "320x200"
+stop_portal
+
+start_portal 640 480 1
+flameshot full --raw >"$OUT"
+check "cancelled capture fails" test "$?" -ne 0
+check "cancelled capture prints nothing" test ! -s "$OUT"
+stop_portal
+
+rm -f "$OUT"
+exit "$FAILED"
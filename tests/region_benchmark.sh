@@ -0,0 +1,46 @@
+#!/usr/bin/env sh
+
+# Compares the time of full desktop/screen captures with region captures, the
+# region is grabbed directly by the backends instead of being cropped out of a
+# full capture
+# Arguments:
+# 1. path to tested flameshot executable
+# 2. number of captures per command (default: 20)
+# 3. region to capture (default: 400x300+100+100)
+
+# HOW TO USE:
+# - Make sure a flameshot daemon with a matching version is running
+# - Start the script, it prints the average time of each command in ms
+#
+# The time includes the PNG encoding of --raw, which also shrinks with the
+# region. Run it once on X11 and once under each Wayland backend (portal,
+# grim) to compare them.
+
+FLAMESHOT="$1"
+[ -z "$FLAMESHOT" ] && FLAMESHOT="flameshot"
+COUNT="$2"
+[ -z "$COUNT" ] && COUNT=20
+REGION="$3"
+[ -z "$REGION" ] && REGION="400x300+100+100"
+
+now_ms() {
+    echo $(($(date +%s%N) / 1000000))
+}
+
+# Print the average time of the given flameshot command
+bench() {
+    command "$FLAMESHOT" "$@" --raw >/dev/null # warm up
+    start=$(now_ms)
+    i=0
+    while [ "$i" -lt "$COUNT" ]; do
+        command "$FLAMESHOT" "$@" --raw >/dev/null
+        i=$((i + 1))
+    done
+    end=$(now_ms)
+    echo "$*: $(((end - start) / COUNT)) ms"
+}
+
+bench full
+bench full --region "$REGION"
+bench screen
+bench screen --region "$REGION"